@@ -0,0 +1,188 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+    Meter and spectrum data from the audio thread to the editor.
+
+    Once per block the audio thread pushes the peak and RMS level of each
+    channel, and the mono downmix of the block averaged down to 48 kHz or
+    less. Both go through single producer, single consumer FIFOs: push() never
+    blocks, locks or allocates, and drops what doesn't fit if the editor falls
+    behind. The editor drains them on its timer.
+
+    Nothing is pushed unless an editor has switched the feed on, so a plugin
+    with its window closed pays one relaxed atomic load per block.
+*/
+class AnalysisFeed
+{
+public:
+    static constexpr int maxChannels = 16;
+
+    struct Levels
+    {
+        int numChannels = 0;
+        std::array<float, maxChannels> peak {}, rms {};
+    };
+
+    AnalysisFeed()
+        : levels((size_t) levelCapacity), samples((size_t) sampleCapacity)
+    {
+    }
+
+    //==============================================================================
+    // Message thread, before playback starts
+    void prepare(double sampleRate) noexcept
+    {
+        decimation = juce::jmax(1, juce::roundToInt(sampleRate / maximumOutputRate));
+        outputRate = sampleRate / decimation;
+        accumulator = 0.0f;
+        numAccumulated = 0;
+    }
+
+    void setEnabled(bool shouldBeEnabled) noexcept { enabled.store(shouldBeEnabled, std::memory_order_relaxed); }
+    bool isEnabled() const noexcept { return enabled.load(std::memory_order_relaxed); }
+
+    //==============================================================================
+    // Audio thread
+    template <typename SampleType>
+    void push(const juce::AudioBuffer<SampleType>& buffer) noexcept
+    {
+        const auto numChannels = juce::jmin(buffer.getNumChannels(), maxChannels);
+        const auto numSamples = buffer.getNumSamples();
+
+        if (! isEnabled() || numChannels == 0 || numSamples == 0)
+            return;
+
+        std::array<double, maxChannels> sumOfSquares {};
+        std::array<SampleType, maxChannels> peaks {};
+        const auto scale = 1.0f / (float) (numChannels * decimation);
+
+        // One pass over the block, a chunk at a time: levels and the mono
+        // downmix are taken while the chunk is in cache, then the downmix is
+        // averaged down and queued
+        for (int start = 0; start < numSamples; start += (int) mono.size())
+        {
+            const auto length = juce::jmin((int) mono.size(), numSamples - start);
+            int numPending = 0;
+            std::fill_n(mono.data(), length, 0.0f);
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                measure(buffer.getReadPointer(channel, start), length, peaks[(size_t) channel], sumOfSquares[(size_t) channel]);
+
+            for (int i = 0; i < length; ++i)
+            {
+                accumulator += mono[(size_t) i];
+
+                if (++numAccumulated < decimation)
+                    continue;
+
+                pending[(size_t) numPending++] = accumulator * scale;
+                accumulator = 0.0f;
+                numAccumulated = 0;
+            }
+
+            write(sampleFifo, samples.data(), pending.data(), numPending);
+        }
+
+        Levels blockLevels;
+        blockLevels.numChannels = numChannels;
+
+        for (size_t channel = 0; channel < (size_t) numChannels; ++channel)
+        {
+            blockLevels.peak[channel] = (float) peaks[channel];
+            blockLevels.rms[channel] = (float) std::sqrt(sumOfSquares[channel] / numSamples);
+        }
+
+        write(levelFifo, levels.data(), &blockLevels, 1);
+    }
+
+    //==============================================================================
+    // Editor. Each returns how many items were copied to the destination.
+    int readLevels(Levels* destination, int maxNumLevels) noexcept
+    {
+        return read(levelFifo, levels.data(), destination, maxNumLevels);
+    }
+
+    int readSamples(float* destination, int maxNumSamples) noexcept
+    {
+        return read(sampleFifo, samples.data(), destination, maxNumSamples);
+    }
+
+    // Rate of the samples returned by readSamples()
+    double getSampleRate() const noexcept { return outputRate; }
+
+private:
+    //==============================================================================
+    static constexpr double maximumOutputRate = 48000.0;
+    static constexpr int levelCapacity = 256;
+    static constexpr int sampleCapacity = 16384;    // A third of a second at 48 kHz
+
+    // Adds one channel's chunk to the downmix and to its level. Four running
+    // sums and peaks, so the loop isn't one long dependency chain.
+    template <typename SampleType>
+    void measure(const SampleType* data, int length, SampleType& peak, double& sumOfSquares) noexcept
+    {
+        SampleType peak4[4] {}, sum4[4] {};
+        int i = 0;
+
+        for (; i + 4 <= length; i += 4)
+        {
+            for (int lane = 0; lane < 4; ++lane)
+            {
+                const auto x = data[i + lane];
+                mono[(size_t) (i + lane)] += (float) x;
+                peak4[lane] = juce::jmax(peak4[lane], std::abs(x));
+                sum4[lane] += x * x;
+            }
+        }
+
+        for (; i < length; ++i)
+        {
+            mono[(size_t) i] += (float) data[i];
+            peak4[0] = juce::jmax(peak4[0], std::abs(data[i]));
+            sum4[0] += data[i] * data[i];
+        }
+
+        peak = juce::jmax(peak, juce::jmax(peak4[0], peak4[1]), juce::jmax(peak4[2], peak4[3]));
+        sumOfSquares += (double) ((sum4[0] + sum4[1]) + (sum4[2] + sum4[3]));
+    }
+
+    template <typename Item>
+    static void write(juce::AbstractFifo& fifo, Item* storage, const Item* source, int numItems) noexcept
+    {
+        const auto scope = fifo.write(numItems);
+
+        std::copy_n(source, scope.blockSize1, storage + scope.startIndex1);
+        std::copy_n(source + scope.blockSize1, scope.blockSize2, storage + scope.startIndex2);
+    }
+
+    template <typename Item>
+    static int read(juce::AbstractFifo& fifo, const Item* storage, Item* destination, int numItems) noexcept
+    {
+        const auto scope = fifo.read(numItems);
+
+        std::copy_n(storage + scope.startIndex1, scope.blockSize1, destination);
+        std::copy_n(storage + scope.startIndex2, scope.blockSize2, destination + scope.blockSize1);
+        return scope.blockSize1 + scope.blockSize2;
+    }
+
+    //==============================================================================
+    std::atomic<bool> enabled { false };
+
+    juce::AbstractFifo levelFifo { levelCapacity };
+    juce::AbstractFifo sampleFifo { sampleCapacity };
+    std::vector<Levels> levels;
+    std::vector<float> samples;
+
+    // Audio thread
+    std::array<float, 256> mono {}, pending {};
+    float accumulator = 0.0f;
+    int numAccumulated = 0;
+    int decimation = 1;
+
+    double outputRate = 44100.0;
+
+    JUCE_DECLARE_NON_COPYABLE(AnalysisFeed)
+};
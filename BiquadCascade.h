@@ -0,0 +1,275 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "BiquadDesign.h"
+
+//==============================================================================
+/*
+    A cascade of biquad sections (transposed direct form II) that runs every
+    enabled section in a single pass over the audio.
+
+    Channels are processed in groups of SIMDRegister lanes: each group is
+    interleaved into a small aligned scratch block, pushed through all stages
+    sample by sample with the filter state held in registers, and written
+    back. A group with a single channel skips the interleaving and runs the
+    same kernel on scalars.
+
+    Disabled sections are left out of the kernel entirely; the number of
+    active stages is a template parameter of the inner loop. A section's
+    state is cleared when it is enabled again, so it starts from rest rather
+    than from whatever it held when it was taken out.
+*/
+template <typename SampleType>
+class BiquadCascade
+{
+public:
+    static constexpr int maxStages = 8;
+    static constexpr int subBlockSize = 64;
+
+    using Register = juce::dsp::SIMDRegister<SampleType>;
+    static constexpr int lanes = (int) Register::SIMDNumElements;
+
+    BiquadCascade() = default;
+
+    //==============================================================================
+    void prepare(const juce::dsp::ProcessSpec& spec)
+    {
+        numChannels = (int) spec.numChannels;
+        numGroups = (numChannels + lanes - 1) / lanes;
+
+        // Extra lanes of padding so the working pointers can be SIMD aligned
+        stateStorage.assign((size_t) (numGroups * maxStages * 2 * lanes + lanes), SampleType());
+        scratchStorage.assign((size_t) (subBlockSize * lanes + lanes), SampleType());
+
+        state = Register::getNextSIMDAlignedPtr(stateStorage.data());
+        scratch = Register::getNextSIMDAlignedPtr(scratchStorage.data());
+
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        if (state != nullptr)
+            std::fill(state, state + numGroups * maxStages * 2 * lanes, SampleType());
+    }
+
+    // True when no state of an enabled section exceeds the threshold. Disabled
+    // sections don't decay, so their state isn't looked at.
+    bool isSettled(SampleType threshold) const noexcept
+    {
+        if (state == nullptr)
+            return true;
+
+        for (int group = 0; group < numGroups; ++group)
+        {
+            for (int stage = 0; stage < maxStages; ++stage)
+            {
+                if (! enabled[(size_t) stage])
+                    continue;
+
+                const auto range = juce::FloatVectorOperations::findMinAndMax(state + (group * maxStages + stage) * 2 * lanes,
+                                                                              2 * lanes);
+
+                if (juce::jmax(-range.getStart(), range.getEnd()) > threshold)
+                    return false;
+            }
+        }
+
+        return true;
+    }
+
+    //==============================================================================
+    void setCoefficients(int stage, const BiquadCoefficients<SampleType>& newCoefficients) noexcept
+    {
+        jassert(juce::isPositiveAndBelow(stage, maxStages));
+        coefficients[(size_t) stage] = newCoefficients;
+    }
+
+    void setStageEnabled(int stage, bool shouldBeEnabled) noexcept
+    {
+        jassert(juce::isPositiveAndBelow(stage, maxStages));
+
+        if (shouldBeEnabled && ! enabled[(size_t) stage] && state != nullptr)
+        {
+            for (int group = 0; group < numGroups; ++group)
+            {
+                auto* stageState = state + (group * maxStages + stage) * 2 * lanes;
+                std::fill(stageState, stageState + 2 * lanes, SampleType());
+            }
+        }
+
+        enabled[(size_t) stage] = shouldBeEnabled;
+    }
+
+    //==============================================================================
+    // Applies all enabled stages in place. A FixedLength above 0 is the
+    // block's length, known at compile time so the compiler can unroll the
+    // per-sample loop; VinylEQ passes it for its full automation steps.
+    template <int FixedLength = 0>
+    void process(const juce::dsp::ProcessContextReplacing<SampleType>& context) noexcept
+    {
+        static_assert(FixedLength >= 0 && FixedLength <= subBlockSize, "A fixed length must fit one scratch block");
+
+        auto& block = context.getOutputBlock();
+        const auto numSamples = FixedLength > 0 ? FixedLength : (int) block.getNumSamples();
+        jassert(numSamples == (int) block.getNumSamples());
+
+        jassert((int) block.getNumChannels() <= numChannels);
+        const auto numChannelsToProcess = juce::jmin((int) block.getNumChannels(), numChannels);
+
+        std::array<int, maxStages> activeStages {};
+        int numActive = 0;
+
+        for (int stage = 0; stage < maxStages; ++stage)
+            if (enabled[(size_t) stage])
+                activeStages[(size_t) numActive++] = stage;
+
+        if (numActive == 0)
+            return;
+
+        for (int first = 0; first < numChannelsToProcess; first += lanes)
+        {
+            const auto groupChannels = juce::jmin(lanes, numChannelsToProcess - first);
+            auto* groupState = state + (first / lanes) * maxStages * 2 * lanes;
+
+            if (groupChannels == 1)
+            {
+                dispatch<ScalarOps, maxStages, FixedLength>(numActive, block.getChannelPointer((size_t) first), numSamples,
+                                                            activeStages.data(), groupState);
+                continue;
+            }
+
+            for (int start = 0; start < numSamples; start += subBlockSize)
+            {
+                const auto length = juce::jmin(subBlockSize, numSamples - start);
+
+                interleave(block, first, groupChannels, start, length);
+                dispatch<SIMDOps, maxStages, FixedLength>(numActive, scratch, length, activeStages.data(), groupState);
+                deinterleave(block, first, groupChannels, start, length);
+            }
+        }
+    }
+
+private:
+    //==============================================================================
+    struct ScalarOps
+    {
+        using Type = SampleType;
+        static constexpr int stride = 1;
+
+        static Type load(const SampleType* p) noexcept          { return *p; }
+        static void store(SampleType* p, Type value) noexcept   { *p = value; }
+        static Type expand(SampleType value) noexcept           { return value; }
+    };
+
+    struct SIMDOps
+    {
+        using Type = Register;
+        static constexpr int stride = lanes;
+
+        static Type load(const SampleType* p) noexcept          { return Register::fromRawArray(p); }
+        static void store(SampleType* p, Type value) noexcept   { value.copyToRawArray(p); }
+        static Type expand(SampleType value) noexcept           { return Register::expand(value); }
+    };
+
+    //==============================================================================
+    template <typename Ops, int NumStages, int FixedLength>
+    void dispatch(int numActive, SampleType* data, int numSamples,
+                  const int* activeStages, SampleType* groupState) const noexcept
+    {
+        if (numActive == NumStages)
+            processStages<Ops, NumStages, FixedLength>(data, numSamples, activeStages, groupState);
+        else if constexpr (NumStages > 1)
+            dispatch<Ops, NumStages - 1, FixedLength>(numActive, data, numSamples, activeStages, groupState);
+    }
+
+    template <typename Ops, int NumStages, int FixedLength>
+    void processStages(SampleType* data, int numSamples,
+                       const int* activeStages, SampleType* groupState) const noexcept
+    {
+        using Type = typename Ops::Type;
+
+        std::array<Type, NumStages> b0, b1, b2, a1, a2, s1, s2;
+
+        for (int i = 0; i < NumStages; ++i)
+        {
+            const auto& c = coefficients[(size_t) activeStages[i]];
+            b0[(size_t) i] = Ops::expand(c.b0);
+            b1[(size_t) i] = Ops::expand(c.b1);
+            b2[(size_t) i] = Ops::expand(c.b2);
+            a1[(size_t) i] = Ops::expand(c.a1);
+            a2[(size_t) i] = Ops::expand(c.a2);
+
+            auto* stageState = groupState + activeStages[i] * 2 * lanes;
+            s1[(size_t) i] = Ops::load(stageState);
+            s2[(size_t) i] = Ops::load(stageState + lanes);
+        }
+
+        const auto length = FixedLength > 0 ? FixedLength : numSamples;
+
+        for (int n = 0; n < length; ++n)
+        {
+            auto* p = data + n * Ops::stride;
+            auto x = Ops::load(p);
+
+            for (size_t i = 0; i < (size_t) NumStages; ++i)
+            {
+                const auto y = x * b0[i] + s1[i];
+                s1[i] = x * b1[i] - y * a1[i] + s2[i];
+                s2[i] = x * b2[i] - y * a2[i];
+                x = y;
+            }
+
+            Ops::store(p, x);
+        }
+
+        for (int i = 0; i < NumStages; ++i)
+        {
+            auto* stageState = groupState + activeStages[i] * 2 * lanes;
+            Ops::store(stageState, s1[(size_t) i]);
+            Ops::store(stageState + lanes, s2[(size_t) i]);
+        }
+    }
+
+    //==============================================================================
+    void interleave(const juce::dsp::AudioBlock<SampleType>& block, int first, int groupChannels,
+                    int start, int length) noexcept
+    {
+        for (int lane = groupChannels; lane < lanes; ++lane)
+            for (int n = 0; n < length; ++n)
+                scratch[n * lanes + lane] = SampleType();
+
+        for (int lane = 0; lane < groupChannels; ++lane)
+        {
+            const auto* source = block.getChannelPointer((size_t) (first + lane)) + start;
+
+            for (int n = 0; n < length; ++n)
+                scratch[n * lanes + lane] = source[n];
+        }
+    }
+
+    void deinterleave(const juce::dsp::AudioBlock<SampleType>& block, int first, int groupChannels,
+                      int start, int length) const noexcept
+    {
+        for (int lane = 0; lane < groupChannels; ++lane)
+        {
+            auto* destination = block.getChannelPointer((size_t) (first + lane)) + start;
+
+            for (int n = 0; n < length; ++n)
+                destination[n] = scratch[n * lanes + lane];
+        }
+    }
+
+    //==============================================================================
+    std::array<BiquadCoefficients<SampleType>, maxStages> coefficients {};
+    std::array<bool, maxStages> enabled {};
+
+    int numChannels = 0;
+    int numGroups = 0;
+
+    std::vector<SampleType> stateStorage, scratchStorage;
+    SampleType* state = nullptr;    // [group][stage][s1, s2][lane]
+    SampleType* scratch = nullptr;  // [sample][lane]
+
+    JUCE_DECLARE_NON_COPYABLE(BiquadCascade)
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+// Normalised biquad coefficients (a0 == 1), stored in the same order as
+// juce::dsp::IIR::Coefficients: b0, b1, b2, a1, a2.
+template <typename SampleType>
+struct BiquadCoefficients
+{
+    SampleType b0 = 1, b1 = 0, b2 = 0, a1 = 0, a2 = 0;
+};
+
+//==============================================================================
+// Closed-form versions of the juce::dsp::IIR::Coefficients::make* designs used
+// by the EQ. They return by value, so they are safe to call from any thread and
+// never touch the heap.
+namespace BiquadDesign
+{
+    constexpr double defaultQ = 0.70710678118654752440;
+
+    template <typename SampleType>
+    BiquadCoefficients<SampleType> normalise(double b0, double b1, double b2,
+                                             double a0, double a1, double a2) noexcept
+    {
+        const auto a0Inv = 1.0 / a0;
+        return { (SampleType) (b0 * a0Inv), (SampleType) (b1 * a0Inv), (SampleType) (b2 * a0Inv),
+                 (SampleType) (a1 * a0Inv), (SampleType) (a2 * a0Inv) };
+    }
+
+    template <typename SampleType>
+    BiquadCoefficients<SampleType> makeLowPass(double sampleRate, double frequency, double Q = defaultQ) noexcept
+    {
+        const auto n = 1.0 / std::tan(juce::MathConstants<double>::pi * frequency / sampleRate);
+        const auto nSquared = n * n;
+        const auto invQ = 1.0 / Q;
+
+        return normalise<SampleType>(1.0, 2.0, 1.0,
+                                     1.0 + invQ * n + nSquared, 2.0 * (1.0 - nSquared), 1.0 - invQ * n + nSquared);
+    }
+
+    template <typename SampleType>
+    BiquadCoefficients<SampleType> makeHighPass(double sampleRate, double frequency, double Q = defaultQ) noexcept
+    {
+        const auto n = std::tan(juce::MathConstants<double>::pi * frequency / sampleRate);
+        const auto nSquared = n * n;
+        const auto invQ = 1.0 / Q;
+
+        return normalise<SampleType>(1.0, -2.0, 1.0,
+                                     1.0 + invQ * n + nSquared, 2.0 * (nSquared - 1.0), 1.0 - invQ * n + nSquared);
+    }
+
+    template <typename SampleType>
+    BiquadCoefficients<SampleType> makePeakFilter(double sampleRate, double frequency, double Q, double gainFactor) noexcept
+    {
+        const auto A = std::sqrt(juce::jmax(0.0, gainFactor));
+        const auto omega = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+        const auto alpha = std::sin(omega) / (Q * 2.0);
+        const auto c2 = -2.0 * std::cos(omega);
+
+        return normalise<SampleType>(1.0 + alpha * A, c2, 1.0 - alpha * A,
+                                     1.0 + alpha / A, c2, 1.0 - alpha / A);
+    }
+    // Magnitude response of sections in series at one frequency, as a gain
+    template <typename SampleType>
+    double getMagnitude(const BiquadCoefficients<SampleType>* sections, int numSections,
+                        double frequency, double sampleRate) noexcept
+    {
+        const auto w = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+        const std::complex<double> z1 = std::polar(1.0, -w), z2 = z1 * z1;
+        double magnitude = 1.0;
+
+        for (int s = 0; s < numSections; ++s)
+        {
+            const auto& c = sections[s];
+            magnitude *= std::abs(((double) c.b0 + (double) c.b1 * z1 + (double) c.b2 * z2)
+                                  / (1.0 + (double) c.a1 * z1 + (double) c.a2 * z2));
+        }
+
+        return magnitude;
+    }
+}
@@ -0,0 +1,306 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "SharedAssets.h"
+
+//==============================================================================
+/*
+    Vinyl crackle: sparse clicks and pops added on top of the signal.
+
+    Events arrive as a Poisson process (exponentially distributed gaps drawn
+    from a small xorshift PRNG). Each event plays one transient from a bank of
+    clicks and pops that is rendered once in prepare(). Between events the
+    generator does no per-sample work at all; while an event is sounding its
+    transient is mixed in with FloatVectorOperations.
+
+    The banks are built from a fixed seed, so every instance has the same set
+    of transients, and they are shared through SharedAssets: one bank per
+    sample rate for the whole process. The event sequence comes from
+    setSeed(), and is restarted by prepare() and reset(), so renders with the
+    same seed are identical.
+*/
+template <typename SampleType>
+class CrackleGenerator
+{
+public:
+    static constexpr int maxVoices = 16;
+
+    CrackleGenerator() = default;
+
+    //==============================================================================
+    void prepare(const juce::dsp::ProcessSpec& spec)
+    {
+        sampleRate = spec.sampleRate;
+
+        // The bank is shared by every instance within a Hz of this rate, so
+        // the layout has to come from the rate it is built at, not this one
+        const auto bankRate = SharedAssets::getKeyRate(sampleRate);
+
+        juce::Random bankRandom(bankSeed);
+        const auto bankSize = (size_t) layoutBanks(bankRandom, bankRate, clicks, pops);
+
+        bank = SharedAssets::get<SampleType>({ "crackle", bankRate, 0 }, bankSize, [bankRate](std::vector<SampleType>& data)
+        {
+            buildBanks(bankRate, data);
+        });
+
+        jassert(bank->template getNumElements<SampleType>() == bankSize);
+        bankData = bank->template getData<SampleType>();
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        random.seed(seed);
+        for (auto& voice : voices)
+            voice.data = nullptr;
+
+        scheduledRate = -1.0f;
+    }
+
+    void setSeed(juce::uint32 newSeed) noexcept     { seed = newSeed; }
+
+    // Average number of events per second, and their peak level
+    void setDensity(float eventsPerSecond) noexcept  { density = juce::jmax(0.0f, eventsPerSecond); }
+    void setLevel(float newLevel) noexcept           { level = juce::jmax(0.0f, newLevel); }
+
+    // How many transients may sound at once, up to maxVoices. Events that
+    // find every voice busy are dropped. Voices above a lowered limit finish.
+    void setMaxVoices(int newLimit) noexcept         { voiceLimit = juce::jlimit(1, maxVoices, newLimit); }
+
+    // The longest transient, a pop: how long one started on the last
+    // sample keeps sounding
+    static constexpr double getMaximumPopSeconds() noexcept     { return maxPopMs * 0.001; }
+
+    bool isActive() const noexcept
+    {
+        if (density > 0.0f && level > 0.0f)
+            return true;
+
+        for (auto& voice : voices)
+            if (voice.data != nullptr)
+                return true;
+
+        return false;
+    }
+
+    //==============================================================================
+    // Adds crackle to the block in place
+    void process(const juce::dsp::ProcessContextReplacing<SampleType>& context) noexcept
+    {
+        auto& block = context.getOutputBlock();
+        const auto numSamples = (int) block.getNumSamples();
+
+        // Transients still sounding from earlier blocks
+        for (auto& voice : voices)
+            if (voice.data != nullptr)
+                mixVoice(voice, block, 0);
+
+        // Poisson's memorylessness means the next event can simply be redrawn
+        // whenever the rate changes
+        const auto rate = level > 0.0f ? density : 0.0f;
+
+        if (rate != scheduledRate)
+        {
+            scheduledRate = rate;
+            samplesUntilNextEvent = nextInterval(rate);
+        }
+
+        while (samplesUntilNextEvent < numSamples)
+        {
+            startVoice(block, (int) samplesUntilNextEvent);
+            samplesUntilNextEvent += juce::jmax((juce::int64) 1, nextInterval(rate));
+        }
+
+        samplesUntilNextEvent -= numSamples;
+    }
+
+private:
+    //==============================================================================
+    // Small, fast PRNG. Only touched once per event.
+    struct XorShift32
+    {
+        void seed(juce::uint32 newSeed) noexcept { state = newSeed != 0 ? newSeed : 0x9e3779b9u; }
+
+        juce::uint32 next() noexcept
+        {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            return state;
+        }
+
+        // Uniform in (0, 1]
+        float nextFloat() noexcept { return (float) ((next() >> 8) + 1) * (1.0f / 16777216.0f); }
+
+        juce::uint32 state = 0x9e3779b9u;
+    };
+
+    struct Transient
+    {
+        int offset = 0;
+        int length = 0;
+    };
+
+    struct Voice
+    {
+        const SampleType* data = nullptr;   // nullptr when idle
+        int length = 0;
+        int position = 0;
+        SampleType gains[2] {};             // Alternating channels, for a little stereo spread
+    };
+
+    static constexpr int numClicks = 24;
+    static constexpr int numPops = 8;
+    static constexpr double minPopMs = 3.0, maxPopMs = 9.0;
+    static constexpr juce::int64 bankSeed = 0x5eed;
+
+    //==============================================================================
+    juce::int64 nextInterval(float rate) noexcept
+    {
+        if (rate <= 0.0f)
+            return std::numeric_limits<juce::int64>::max() / 2;
+
+        return (juce::int64) (-std::log(random.nextFloat()) * sampleRate / rate);
+    }
+
+    void startVoice(const juce::dsp::AudioBlock<SampleType>& block, int offset) noexcept
+    {
+        const auto end = voices.begin() + voiceLimit;
+        auto voice = std::find_if(voices.begin(), end, [](const Voice& v) { return v.data == nullptr; });
+
+        if (voice == end)
+            return; // Too dense to hear the difference, drop the event
+
+        // Mostly clicks, now and then a pop
+        const auto isPop = random.nextFloat() < 0.2f;
+        const auto index = (int) (random.next() % (juce::uint32) (isPop ? numPops : numClicks));
+        const auto& transient = isPop ? pops[(size_t) index] : clicks[(size_t) index];
+
+        // Most events are quiet, a few are loud
+        const auto u = random.nextFloat();
+        const auto amplitude = level * (0.15f + 0.85f * u * u * u) * ((random.next() & 1) != 0 ? 1.0f : -1.0f);
+        const auto pan = random.nextFloat();
+
+        voice->data = bankData + transient.offset;
+        voice->length = transient.length;
+        voice->position = 0;
+        voice->gains[0] = (SampleType) (amplitude * std::sqrt(1.0f - pan * 0.6f));
+        voice->gains[1] = (SampleType) (amplitude * std::sqrt(0.4f + pan * 0.6f));
+
+        mixVoice(*voice, block, offset);
+    }
+
+    void mixVoice(Voice& voice, const juce::dsp::AudioBlock<SampleType>& block, int offset) noexcept
+    {
+        const auto numToMix = juce::jmin(voice.length - voice.position, (int) block.getNumSamples() - offset);
+
+        for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+            juce::FloatVectorOperations::addWithMultiply(block.getChannelPointer(channel) + offset,
+                                                         voice.data + voice.position,
+                                                         voice.gains[channel & 1], numToMix);
+
+        voice.position += numToMix;
+
+        if (voice.position >= voice.length)
+            voice.data = nullptr;
+    }
+
+    //==============================================================================
+    // Where each transient sits in the bank, and the bank's total length. Takes
+    // the first values from bankRandom, so every instance gets the same layout.
+    static int layoutBanks(juce::Random& bankRandom, double rate,
+                           std::array<Transient, numClicks>& clickLayout, std::array<Transient, numPops>& popLayout)
+    {
+        auto msToSamples = [rate](double ms) { return juce::jmax(8, juce::roundToInt(ms * 0.001 * rate)); };
+
+        int total = 0;
+        for (auto& click : clickLayout)
+        {
+            click = { total, msToSamples(0.3 + 1.2 * bankRandom.nextDouble()) };
+            total += click.length;
+        }
+
+        for (auto& pop : popLayout)
+        {
+            pop = { total, msToSamples(minPopMs + (maxPopMs - minPopMs) * bankRandom.nextDouble()) };
+            total += pop.length;
+        }
+
+        return total;
+    }
+
+    static void buildBanks(double rate, std::vector<SampleType>& data)
+    {
+        juce::Random bankRandom(bankSeed);
+        std::array<Transient, numClicks> clickLayout;
+        std::array<Transient, numPops> popLayout;
+
+        data.assign((size_t) layoutBanks(bankRandom, rate, clickLayout, popLayout), SampleType());
+
+        // Clicks: differentiated, fast-decaying noise bursts
+        for (auto& click : clickLayout)
+        {
+            auto* samples = data.data() + click.offset;
+            const auto decay = 0.2 * click.length;
+            double previous = 0.0;
+
+            for (int n = 0; n < click.length; ++n)
+            {
+                const auto value = (bankRandom.nextDouble() * 2.0 - 1.0) * std::exp(-n / decay);
+                samples[n] = (SampleType) (value - previous);
+                previous = value;
+            }
+
+            normalise(samples, click.length);
+        }
+
+        // Pops: a low thump, damped sine plus a short burst at the start
+        for (auto& pop : popLayout)
+        {
+            auto* samples = data.data() + pop.offset;
+            const auto frequency = 150.0 + 500.0 * bankRandom.nextDouble();
+            const auto phase = juce::MathConstants<double>::twoPi * bankRandom.nextDouble();
+            const auto decay = 0.25 * pop.length;
+
+            for (int n = 0; n < pop.length; ++n)
+            {
+                auto value = std::sin(juce::MathConstants<double>::twoPi * frequency * n / rate + phase);
+
+                if (n < 16)
+                    value += bankRandom.nextDouble() * 2.0 - 1.0;
+
+                samples[n] = (SampleType) (value * std::exp(-n / decay));
+            }
+
+            normalise(samples, pop.length);
+        }
+    }
+
+    static void normalise(SampleType* data, int length) noexcept
+    {
+        const auto range = juce::FloatVectorOperations::findMinAndMax(data, length);
+        const auto peak = juce::jmax(std::abs(range.getStart()), std::abs(range.getEnd()));
+
+        if (peak > SampleType())
+            juce::FloatVectorOperations::multiply(data, SampleType(1) / peak, length);
+    }
+
+    //==============================================================================
+    double sampleRate = 44100.0;
+    float density = 0.0f, level = 0.0f;
+    float scheduledRate = -1.0f;
+    juce::int64 samplesUntilNextEvent = 0;
+
+    juce::uint32 seed = 1;
+    XorShift32 random;
+
+    std::shared_ptr<const SharedAsset> bank;
+    const SampleType* bankData = nullptr;
+    std::array<Transient, numClicks> clicks;
+    std::array<Transient, numPops> pops;
+    std::array<Voice, maxVoices> voices;
+    int voiceLimit = maxVoices;
+
+    JUCE_DECLARE_NON_COPYABLE(CrackleGenerator)
+};
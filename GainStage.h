@@ -0,0 +1,68 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+    Volume stage. The target gain is set once per block and ramped linearly to
+    avoid zipper noise; the gain itself is applied with FloatVectorOperations.
+    A settled gain of exactly 1 leaves the audio untouched.
+*/
+template <typename SampleType>
+class GainStage
+{
+public:
+    GainStage() = default;
+
+    //==============================================================================
+    // Snaps to the current target, so playback never starts with a ramp
+    void prepare(const juce::dsp::ProcessSpec& spec) noexcept
+    {
+        gain.reset(spec.sampleRate, rampLengthSeconds);
+    }
+
+    void setGain(SampleType newGain) noexcept
+    {
+        gain.setTargetValue(newGain);
+    }
+
+    //==============================================================================
+    void process(const juce::dsp::ProcessContextReplacing<SampleType>& context) noexcept
+    {
+        auto& block = context.getOutputBlock();
+        const auto numChannels = block.getNumChannels();
+        const auto numSamples = block.getNumSamples();
+
+        if (! gain.isSmoothing())
+        {
+            const auto value = gain.getTargetValue();
+
+            if (value == SampleType(1))
+                return;
+
+            for (size_t channel = 0; channel < numChannels; ++channel)
+                juce::FloatVectorOperations::multiply(block.getChannelPointer(channel), value, (int) numSamples);
+
+            return;
+        }
+
+        for (size_t start = 0; start < numSamples; start += ramp.size())
+        {
+            const auto length = juce::jmin(ramp.size(), numSamples - start);
+
+            for (size_t i = 0; i < length; ++i)
+                ramp[i] = gain.getNextValue();
+
+            for (size_t channel = 0; channel < numChannels; ++channel)
+                juce::FloatVectorOperations::multiply(block.getChannelPointer(channel) + start, ramp.data(), (int) length);
+        }
+    }
+
+private:
+    static constexpr double rampLengthSeconds = 0.02;
+
+    juce::SmoothedValue<SampleType, juce::ValueSmoothingTypes::Linear> gain { SampleType(1) };
+    std::array<SampleType, 64> ramp {};
+
+    JUCE_DECLARE_NON_COPYABLE(GainStage)
+};
@@ -0,0 +1,87 @@
+#include "LevelMeter.h"
+
+//==============================================================================
+
+LevelMeter::LevelMeter()
+{
+    peak.fill(minDecibels);
+    rms.fill(minDecibels);
+    setOpaque(true);
+}
+
+void LevelMeter::setLevels(const AnalysisFeed::Levels& levels)
+{
+    // A new channel count moves every bar
+    if (levels.numChannels > 0 && levels.numChannels != numChannels)
+        repaint();
+
+    if (levels.numChannels > 0)
+        numChannels = levels.numChannels;
+
+    juce::Rectangle<int> dirty;
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        const auto i = (size_t) channel;
+        const auto hasLevel = channel < levels.numChannels;
+        const auto newPeak = juce::jmax(hasLevel ? juce::Decibels::gainToDecibels(levels.peak[i], minDecibels) : minDecibels,
+                                        peak[i] - releaseDecibels);
+        const auto newRMS = juce::jmax(hasLevel ? juce::Decibels::gainToDecibels(levels.rms[i], minDecibels) : minDecibels,
+                                       rms[i] - releaseDecibels);
+
+        const int ys[] { getY(peak[i]), getY(newPeak), getY(rms[i]), getY(newRMS) };
+
+        if (ys[0] != ys[1] || ys[2] != ys[3])
+        {
+            // The peak line is 2 pixels high
+            const auto top = *std::min_element(std::begin(ys), std::end(ys));
+            const auto bottom = *std::max_element(std::begin(ys), std::end(ys)) + 2;
+            const auto column = getBarColumn(channel);
+
+            dirty = dirty.getUnion(column.withTop(top).withBottom(juce::jmax(top + 1, bottom)));
+        }
+
+        peak[i] = newPeak;
+        rms[i] = newRMS;
+    }
+
+    if (! dirty.isEmpty())
+        repaint(dirty);
+}
+
+void LevelMeter::paint(juce::Graphics& g)
+{
+    g.fillAll(juce::Colours::black);
+
+    if (numChannels == 0)
+        return;
+
+    const auto barWidth = (float) getWidth() / (float) numChannels;
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        const auto x = barWidth * (float) channel;
+        const auto rmsY = (float) getY(rms[(size_t) channel]);
+        const auto peakY = (float) getY(peak[(size_t) channel]);
+
+        g.setColour(juce::Colours::green);
+        g.fillRect(x, rmsY, juce::jmax(1.0f, barWidth - 1.0f), (float) getHeight() - rmsY);
+
+        g.setColour(peak[(size_t) channel] >= 0.0f ? juce::Colours::red : juce::Colours::lightgreen);
+        g.fillRect(x, peakY, juce::jmax(1.0f, barWidth - 1.0f), 2.0f);
+    }
+}
+
+juce::Rectangle<int> LevelMeter::getBarColumn(int channel) const noexcept
+{
+    const auto barWidth = (float) getWidth() / (float) juce::jmax(1, numChannels);
+    const auto left = (int) std::floor(barWidth * (float) channel);
+    const auto right = (int) std::ceil(barWidth * (float) (channel + 1));
+
+    return { left, 0, right - left, getHeight() };
+}
+
+int LevelMeter::getY(float decibels) const noexcept
+{
+    return juce::roundToInt(juce::jmap(juce::jlimit(minDecibels, 0.0f, decibels), minDecibels, 0.0f, (float) getHeight(), 0.0f));
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "AnalysisFeed.h"
+
+//==============================================================================
+/*
+    Output level meter: one bar per channel, RMS filled and peak as a line,
+    from -60 dB to 0 dB. Levels fall back slowly after a peak. It only
+    repaints itself, and only the rows between a bar's old and new levels,
+    when they moved by at least a pixel.
+*/
+class LevelMeter : public juce::Component
+{
+public:
+    LevelMeter();
+
+    // Levels since the last call, from the editor's timer. No channels means
+    // no new levels came in, and the bars fall back.
+    void setLevels(const AnalysisFeed::Levels& levels);
+
+    void paint(juce::Graphics&) override;
+
+private:
+    static constexpr float minDecibels = -60.0f;
+    static constexpr float releaseDecibels = 1.0f;      // Per update, 30 dB/s at 30 Hz
+
+    int getY(float decibels) const noexcept;
+    juce::Rectangle<int> getBarColumn(int channel) const noexcept;
+
+    int numChannels = 0;
+    std::array<float, AnalysisFeed::maxChannels> peak, rms;     // Decibels as shown
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LevelMeter)
+};
@@ -0,0 +1,292 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "VinylEQ.h"
+
+//==============================================================================
+// One background thread for every instance's linear-phase EQ kernels
+class LinearPhaseDesignThread : public juce::TimeSliceThread
+{
+public:
+    LinearPhaseDesignThread() : juce::TimeSliceThread("Vinyl EQ kernels") { startThread(); }
+    ~LinearPhaseDesignThread() override { stopThread(1000); }
+};
+
+//==============================================================================
+/*
+    Linear-phase version of the three EQ controls, for mastering.
+
+    The kernel is a Hann-windowed FIR with the magnitude response of the
+    sections VinylEQ runs for the same values, and no phase shift: it delays
+    everything by half its length instead. It is about 85 ms long at any sample
+    rate, enough to resolve the 80 Hz high-passes. Each channel runs it through
+    a juce::dsp::Convolution with uniform partitions of partitionSize samples,
+    which is float only; the double chain converts around it.
+
+    When the values change, the kernel is redesigned on a shared background
+    thread and handed to the audio thread without locks; the convolution
+    builds its partitions on its own shared thread and crossfades to them.
+    While the stage is off, the convolutions hold a single tap at the
+    kernel's centre: half a kernel long, so instances that never use linear
+    phase keep no full kernels around, and until the first designed kernel
+    is live the audio is already delayed by the latency the plugin reports.
+*/
+template <typename SampleType>
+class LinearPhaseEQ : private juce::TimeSliceClient
+{
+public:
+    static constexpr int partitionSize = 256;
+
+    LinearPhaseEQ() = default;
+
+    ~LinearPhaseEQ() override
+    {
+        designThread->removeTimeSliceClient(this);
+    }
+
+    // Kernel length at a sample rate, a power of two
+    static int getKernelSize(double rate) noexcept
+    {
+        return juce::nextPowerOfTwo((int) std::ceil(rate * 0.085));
+    }
+
+    //==============================================================================
+    // Message thread. The kernel for the values last set is active from the first block.
+    void prepare(const juce::dsp::ProcessSpec& spec)
+    {
+        // Waits for a design in progress, so nothing below races the designer
+        designThread->removeTimeSliceClient(this);
+
+        sampleRate = spec.sampleRate;
+        kernelSize = getKernelSize(sampleRate);
+
+        designedState = getRequestedState();
+        const auto kernel = makeKernel(designedState);
+
+        convolutions.clear();
+        pendingKernels.clear();
+
+        for (juce::uint32 channel = 0; channel < spec.numChannels; ++channel)
+        {
+            auto convolution = std::make_unique<juce::dsp::Convolution>(juce::dsp::Convolution::Latency { partitionSize },
+                                                                        *messageQueue);
+
+            // Loaded before prepare(), so it is in place for the first block
+            auto copy = kernel;
+            convolution->loadImpulseResponse(std::move(copy), sampleRate, juce::dsp::Convolution::Stereo::no,
+                                             juce::dsp::Convolution::Trim::no, juce::dsp::Convolution::Normalise::no);
+            convolution->prepare({ spec.sampleRate, spec.maximumBlockSize, 1 });
+
+            convolutions.push_back(std::move(convolution));
+        }
+
+        pendingKernels.resize(convolutions.size());
+        kernelsReady.store(false, std::memory_order_relaxed);
+
+        if constexpr (! std::is_same_v<SampleType, float>)
+            scratch.setSize(1, (int) spec.maximumBlockSize);
+
+        designThread->addTimeSliceClient(this);
+    }
+
+    void reset() noexcept
+    {
+        for (auto& convolution : convolutions)
+            convolution->reset();
+    }
+
+    // Audio thread, once per block whether the stage runs or not. Queues a
+    // redesign if anything changed, and installs kernels designed since the
+    // last call.
+    void setValues(bool shouldBeEnabled, SampleType firstEQ, SampleType lowCut, SampleType highCut) noexcept
+    {
+        requestedEnabled.store(shouldBeEnabled, std::memory_order_relaxed);
+        requestedValues[0].store((float) firstEQ, std::memory_order_relaxed);
+        requestedValues[1].store((float) lowCut, std::memory_order_relaxed);
+        requestedValues[2].store((float) highCut, std::memory_order_relaxed);
+
+        if (! kernelsReady.load(std::memory_order_acquire))
+            return;
+
+        for (size_t channel = 0; channel < convolutions.size(); ++channel)
+            convolutions[channel]->loadImpulseResponse(std::move(pendingKernels[channel]), sampleRate,
+                                                       juce::dsp::Convolution::Stereo::no,
+                                                       juce::dsp::Convolution::Trim::no,
+                                                       juce::dsp::Convolution::Normalise::no);
+
+        kernelsReady.store(false, std::memory_order_release);
+    }
+
+    // Kernel delay plus the convolution's own. Valid after prepare().
+    int getLatencyInSamples() const noexcept
+    {
+        return kernelSize / 2 + (convolutions.empty() ? partitionSize : convolutions.front()->getLatency());
+    }
+
+    // Longest a sound can take to come out, for the silence bypass
+    int getTailLengthInSamples() const noexcept
+    {
+        return kernelSize + (convolutions.empty() ? partitionSize : convolutions.front()->getLatency());
+    }
+
+    //==============================================================================
+    void process(const juce::dsp::ProcessContextReplacing<SampleType>& context) noexcept
+    {
+        auto& block = context.getOutputBlock();
+        const auto numChannels = juce::jmin(block.getNumChannels(), convolutions.size());
+
+        for (size_t channel = 0; channel < numChannels; ++channel)
+        {
+            auto channelBlock = block.getSingleChannelBlock(channel);
+
+            if constexpr (std::is_same_v<SampleType, float>)
+            {
+                convolutions[channel]->process(juce::dsp::ProcessContextReplacing<float>(channelBlock));
+            }
+            else
+            {
+                const auto numSamples = (int) channelBlock.getNumSamples();
+                auto* data = channelBlock.getChannelPointer(0);
+                auto* floatData = scratch.getWritePointer(0);
+
+                for (int i = 0; i < numSamples; ++i)
+                    floatData[i] = (float) data[i];
+
+                juce::dsp::AudioBlock<float> floatBlock(scratch.getArrayOfWritePointers(), 1, (size_t) numSamples);
+                convolutions[channel]->process(juce::dsp::ProcessContextReplacing<float>(floatBlock));
+
+                for (int i = 0; i < numSamples; ++i)
+                    data[i] = (SampleType) floatData[i];
+            }
+        }
+    }
+
+    //==============================================================================
+    // Fills kernel[0, getKernelSize(rate)) with the linear-phase kernel for
+    // these control values (Vinyl EQ, Low Cut, High Cut). Allocates.
+    static void designKernel(double rate, const std::array<float, 3>& values, float* kernel)
+    {
+        using EQ = VinylEQ<double>;
+        using Complex = juce::dsp::Complex<float>;
+
+        std::array<BiquadCoefficients<double>, EQ::numControls * EQ::maxSectionsPerControl> sections;
+        int numSections = 0;
+
+        for (int i = 0; i < EQ::numControls; ++i)
+        {
+            if (values[(size_t) i] <= 0.0f)
+                continue;
+
+            EQ::design((EQ::Control) i, rate, values[(size_t) i], sections.data() + numSections);
+            numSections += EQ::getNumSections((EQ::Control) i);
+        }
+
+        // Zero-phase spectrum: the magnitude response, real and even
+        const auto size = getKernelSize(rate);
+        std::vector<Complex> spectrum((size_t) size), impulse((size_t) size);
+
+        for (int bin = 0; bin <= size / 2; ++bin)
+        {
+            const auto magnitude = (float) BiquadDesign::getMagnitude(sections.data(), numSections,
+                                                                      bin * rate / size, rate);
+            spectrum[(size_t) bin] = magnitude;
+            spectrum[(size_t) ((size - bin) % size)] = magnitude;
+        }
+
+        juce::dsp::FFT fft(juce::roundToInt(std::log2(size)));
+        fft.perform(spectrum.data(), impulse.data(), true);
+
+        // The impulse is centred on sample 0; move its centre to size / 2 and window it
+        for (int n = 0; n < size; ++n)
+        {
+            const auto window = 0.5f - 0.5f * std::cos(juce::MathConstants<float>::twoPi * (float) n / (float) size);
+            kernel[n] = impulse[(size_t) ((n + size / 2) % size)].real() * window;
+        }
+    }
+
+private:
+    //==============================================================================
+    static constexpr int pollIntervalMs = 20;
+
+    struct KernelState
+    {
+        bool enabled = false;
+        std::array<float, 3> values {};
+
+        bool operator==(const KernelState& other) const noexcept
+        {
+            return enabled == other.enabled && (! enabled || values == other.values);
+        }
+    };
+
+    KernelState getRequestedState() const noexcept
+    {
+        KernelState state;
+        state.enabled = requestedEnabled.load(std::memory_order_relaxed);
+
+        for (size_t i = 0; i < state.values.size(); ++i)
+            state.values[i] = requestedValues[i].load(std::memory_order_relaxed);
+
+        return state;
+    }
+
+    // A delay of half the kernel while the stage is off, which is where a
+    // designed kernel's centre sits
+    juce::AudioBuffer<float> makeKernel(const KernelState& state) const
+    {
+        juce::AudioBuffer<float> kernel(1, state.enabled ? kernelSize : kernelSize / 2 + 1);
+        kernel.clear();
+
+        if (state.enabled)
+            designKernel(sampleRate, state.values, kernel.getWritePointer(0));
+        else
+            kernel.setSample(0, kernelSize / 2, 1.0f);
+
+        return kernel;
+    }
+
+    // Design thread
+    int useTimeSlice() override
+    {
+        // The audio thread hasn't installed the last kernels yet
+        if (kernelsReady.load(std::memory_order_acquire))
+            return pollIntervalMs;
+
+        const auto state = getRequestedState();
+
+        if (state == designedState)
+            return pollIntervalMs;
+
+        designedState = state;
+        const auto kernel = makeKernel(state);
+
+        for (auto& pending : pendingKernels)
+            pending = kernel;
+
+        kernelsReady.store(true, std::memory_order_release);
+        return 0;
+    }
+
+    //==============================================================================
+    juce::SharedResourcePointer<LinearPhaseDesignThread> designThread;
+    juce::SharedResourcePointer<juce::dsp::ConvolutionMessageQueue> messageQueue;
+
+    std::vector<std::unique_ptr<juce::dsp::Convolution>> convolutions;
+    juce::AudioBuffer<float> scratch;   // Double chain only
+
+    double sampleRate = 44100.0;
+    int kernelSize = 0;
+
+    // Written by the audio thread, read by the design thread
+    std::atomic<bool> requestedEnabled { false };
+    std::array<std::atomic<float>, 3> requestedValues {};
+
+    // Written by the design thread while kernelsReady is false, then moved
+    // out by the audio thread while it is true
+    std::vector<juce::AudioBuffer<float>> pendingKernels;
+    std::atomic<bool> kernelsReady { false };
+
+    KernelState designedState;          // Design thread, and prepare()
+
+    JUCE_DECLARE_NON_COPYABLE(LinearPhaseEQ)
+};
@@ -1,174 +1,366 @@
-#include "PluginProcessor.h"
-#include "PluginEditor.h"
-
-//==============================================================================
-
-VinylAudioProcessorEditor::VinylAudioProcessorEditor(VinylAudioProcessor& p)
-    : AudioProcessorEditor(&p), audioProcessor(p)
-{
-    // Volume slider
-    volumeSlider.setSliderStyle(juce::Slider::SliderStyle::LinearVertical);
-    volumeSlider.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 50, 20);
-    addAndMakeVisible(volumeSlider);
-
-    volumeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
-        audioProcessor.getParameters(), "VOLUME", volumeSlider);
-
-    // Vinyl crackle noise
-    crackleComboBox.addItem("Subtle Crackle", 1);
-    crackleComboBox.addItem("Medium Crackle", 2);
-    crackleComboBox.addItem("Heavy Crackle", 3);
-    crackleComboBox.setSelectedId(1); // Default to "Subtle Crackle"
-    addAndMakeVisible(crackleComboBox);
-
-    crackleLabel.setText("Vinyl Crackle", juce::dontSendNotification);
-    crackleLabel.setFont(juce::Font(14.0f, juce::Font::bold));
-    crackleLabel.setJustificationType(juce::Justification::centred);
-    addAndMakeVisible(crackleLabel);
-
-    // Saturation knob
-    saturationKnob.setSliderStyle(juce::Slider::Rotary);
-    saturationKnob.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 50, 20);
-    saturationKnob.setRange(0.0f, 1.0f, 0.01f);
-    saturationKnob.setValue(0.0f);
-    saturationKnob.setLookAndFeel(&lookAndFeelV4); // Apply LookAndFeel_V4
-    addAndMakeVisible(saturationKnob);
-
-    saturationLabel.setText("Distortion / Saturation", juce::dontSendNotification);
-    saturationLabel.setFont(juce::Font(14.0f, juce::Font::bold));
-    saturationLabel.setJustificationType(juce::Justification::centred);
-    addAndMakeVisible(saturationLabel);
-
-    // Wobble knob
-    wobbleKnob.setSliderStyle(juce::Slider::Rotary);
-    wobbleKnob.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 50, 20);
-    wobbleKnob.setRange(0.0f, 1.0f, 0.01f);
-    wobbleKnob.setValue(0.0f);
-    wobbleKnob.setLookAndFeel(&lookAndFeelV4); // Apply LookAndFeel_V4
-    addAndMakeVisible(wobbleKnob);
-
-    wobbleLabel.setText("Wobble Effect", juce::dontSendNotification);
-    wobbleLabel.setFont(juce::Font(14.0f, juce::Font::bold));
-    wobbleLabel.setJustificationType(juce::Justification::centred);
-    addAndMakeVisible(wobbleLabel);
-
-    // EQ sliders and buttons 
-    for (int i = 0; i < 3; ++i)
-    {
-        eqSliders[i].setSliderStyle(juce::Slider::SliderStyle::LinearVertical);
-        eqSliders[i].setTextBoxStyle(juce::Slider::NoTextBox, false, 50, 20);
-        eqSliders[i].setRange(0.0f, 1.0f, 0.01f);
-        eqSliders[i].setValue(0.0f);
-        eqSliders[i].setColour(juce::Slider::thumbColourId, juce::Colours::darkgrey);
-        eqSliders[i].setColour(juce::Slider::trackColourId, juce::Colours::grey);
-        eqSliders[i].setEnabled(false);
-        addAndMakeVisible(eqSliders[i]);
-
-        eqButtons[i].setButtonText("EQ Toggle " + juce::String(i + 1));
-        eqButtons[i].setClickingTogglesState(true);
-        eqButtons[i].onClick = [this, i] { handleToggleButtonClicked(i); };
-        eqButtons[i].setColour(juce::TextButton::buttonColourId, juce::Colours::darkgrey);
-        addAndMakeVisible(eqButtons[i]);
-    }
-
-    setSize(900, 675);
-}
-
-VinylAudioProcessorEditor::~VinylAudioProcessorEditor()
-{
-    // Knobs design (should be implemented)
-    saturationKnob.setLookAndFeel(nullptr);
-    wobbleKnob.setLookAndFeel(nullptr);
-}
-
-//==============================================================================
-
-void VinylAudioProcessorEditor::paint(juce::Graphics& g)
-{
-    g.fillAll(juce::Colours::black);
-    g.setColour(juce::Colours::white);
-    g.setFont(15.0f);
-
-    // Llines for 2x2 grid
-    int remainingWidth = getWidth() - 130;
-    int remainingHeight = getHeight() - 100;
-    int quadrantWidth = remainingWidth / 2;
-    int quadrantHeight = remainingHeight / 2;
-
-    g.drawLine(110, 50 + quadrantHeight, 110 + remainingWidth, 50 + quadrantHeight, 2.0f);
-    g.drawLine(110 + quadrantWidth, 50, 110 + quadrantWidth, 50 + remainingHeight, 2.0f);
-}
-
-void VinylAudioProcessorEditor::resized()
-{
-    // Volume slider
-    volumeSlider.setBounds(10, 50, 80, getHeight() - 100);
-
-    // Quadrants dimensions
-    int quadrantWidth = (getWidth() - 130) / 2;
-    int quadrantHeight = (getHeight() - 100) / 2;
-    int xOffset = 110;
-    int yOffset = 50;
-
-    // Vinyl crackle control (top-left quadrant)
-    const int crackleMargin = 10;
-    crackleLabel.setBounds(xOffset, yOffset, quadrantWidth - crackleMargin, 20);
-    crackleComboBox.setBounds(xOffset, yOffset + 30, quadrantWidth - crackleMargin, 30);
-
-    // Saturation knob (bottom-left quadrant)
-    int saturationYOffset = yOffset + quadrantHeight + 10;
-    int knobWidth = quadrantWidth / 2; // Half of the quadrant width
-    saturationLabel.setBounds(xOffset, saturationYOffset, quadrantWidth, 20);
-    saturationKnob.setBounds(xOffset + (quadrantWidth - knobWidth) / 2, saturationYOffset + 30, knobWidth, knobWidth);
-
-    // Wobble knob (bottom-right quadrant)
-    int wobbleXOffset = xOffset + quadrantWidth + 10; // Start at the bottom-right quadrant
-    wobbleLabel.setBounds(wobbleXOffset, saturationYOffset, quadrantWidth, 20);
-    wobbleKnob.setBounds(wobbleXOffset + (quadrantWidth - knobWidth) / 2, saturationYOffset + 30, knobWidth, knobWidth);
-
-    // EQ sliders and buttons (top-right quadrant)
-    int sliderWidth = quadrantWidth / 3;
-    int sliderHeight = quadrantHeight - 50;
-
-    for (int i = 0; i < 3; ++i)
-    {
-        eqSliders[i].setBounds(110 + quadrantWidth + i * sliderWidth, 50, sliderWidth, sliderHeight);
-        eqButtons[i].setBounds(110 + quadrantWidth + i * sliderWidth + 10, 50 + sliderHeight + 10, sliderWidth - 20, 30);
-    }
-}
-
-//==============================================================================
-
-void VinylAudioProcessorEditor::handleToggleButtonClicked(int buttonIndex)
-{
-    for (int i = 0; i < 3; ++i)
-    {
-        if (i != buttonIndex)
-        {
-            eqButtons[i].setToggleState(false, juce::dontSendNotification);
-            eqSliders[i].setEnabled(false);
-            eqSliders[i].setColour(juce::Slider::thumbColourId, juce::Colours::darkgrey);
-            eqSliders[i].setColour(juce::Slider::trackColourId, juce::Colours::grey);
-            eqButtons[i].setColour(juce::TextButton::buttonColourId, juce::Colours::darkgrey);
-
-            if (i == 0)
-                audioProcessor.setFirstEQSliderValue(0.0f);
-            else if (i == 1)
-                audioProcessor.setLowCutValue(0.0f);
-            else if (i == 2)
-                audioProcessor.setHighCutValue(0.0f);
-        }
-    }
-
-    eqSliders[buttonIndex].setEnabled(true);
-    eqSliders[buttonIndex].setColour(juce::Slider::thumbColourId, juce::Colours::green);
-    eqSliders[buttonIndex].setColour(juce::Slider::trackColourId, juce::Colours::lightgreen);
-    eqButtons[buttonIndex].setColour(juce::TextButton::buttonColourId, juce::Colours::green);
-
-    if (buttonIndex == 0)
-        audioProcessor.setFirstEQSliderValue(eqSliders[0].getValue());
-    else if (buttonIndex == 1)
-        audioProcessor.setLowCutValue(eqSliders[1].getValue());
-    else if (buttonIndex == 2)
-        audioProcessor.setHighCutValue(eqSliders[2].getValue());
-}
+#include "PluginProcessor.h"
+#include "PluginEditor.h"
+
+//==============================================================================
+
+VinylAudioProcessorEditor::VinylAudioProcessorEditor(VinylAudioProcessor& p)
+    : AudioProcessorEditor(&p), audioProcessor(p)
+{
+    // Volume slider
+    volumeSlider.setSliderStyle(juce::Slider::SliderStyle::LinearVertical);
+    volumeSlider.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 50, 20);
+    addAndMakeVisible(volumeSlider);
+
+    volumeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
+        audioProcessor.getParameters(), "VOLUME", volumeSlider);
+
+    // Vinyl crackle noise
+    for (size_t i = 0; i < VinylAudioProcessor::cracklePresets.size(); ++i)
+        crackleComboBox.addItem(VinylAudioProcessor::cracklePresets[i].name, (int) i + 1);
+
+    crackleComboBox.setSelectedId(audioProcessor.getCracklePresetIndex() + 1, juce::dontSendNotification);
+    crackleComboBox.onChange = [this] { audioProcessor.setCracklePreset(crackleComboBox.getSelectedItemIndex()); };
+    addAndMakeVisible(crackleComboBox);
+
+    crackleLabel.setText("Vinyl Crackle", juce::dontSendNotification);
+    crackleLabel.setFont(juce::Font(14.0f, juce::Font::bold));
+    crackleLabel.setJustificationType(juce::Justification::centred);
+    addAndMakeVisible(crackleLabel);
+
+    // Saturation knob
+    saturationKnob.setSliderStyle(juce::Slider::Rotary);
+    saturationKnob.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 50, 20);
+    saturationKnob.setLookAndFeel(&lookAndFeelV4); // Apply LookAndFeel_V4
+    addAndMakeVisible(saturationKnob);
+
+    saturationAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
+        audioProcessor.getParameters(), "SATURATION", saturationKnob);
+
+    saturationLabel.setText("Distortion / Saturation", juce::dontSendNotification);
+    saturationLabel.setFont(juce::Font(14.0f, juce::Font::bold));
+    saturationLabel.setJustificationType(juce::Justification::centred);
+    addAndMakeVisible(saturationLabel);
+
+    // Wobble knob
+    wobbleKnob.setSliderStyle(juce::Slider::Rotary);
+    wobbleKnob.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 50, 20);
+    wobbleKnob.setLookAndFeel(&lookAndFeelV4); // Apply LookAndFeel_V4
+    addAndMakeVisible(wobbleKnob);
+
+    wobbleAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
+        audioProcessor.getParameters(), "WOBBLE", wobbleKnob);
+
+    wobbleLabel.setText("Wobble Effect", juce::dontSendNotification);
+    wobbleLabel.setFont(juce::Font(14.0f, juce::Font::bold));
+    wobbleLabel.setJustificationType(juce::Justification::centred);
+    addAndMakeVisible(wobbleLabel);
+
+    // EQ sliders and buttons 
+    for (int i = 0; i < 3; ++i)
+    {
+        eqSliders[i].setSliderStyle(juce::Slider::SliderStyle::LinearVertical);
+        eqSliders[i].setTextBoxStyle(juce::Slider::NoTextBox, false, 50, 20);
+        eqSliders[i].setRange(0.0f, 1.0f, 0.01f);
+        eqSliders[i].setValue(0.0f);
+        eqSliders[i].setColour(juce::Slider::thumbColourId, juce::Colours::darkgrey);
+        eqSliders[i].setColour(juce::Slider::trackColourId, juce::Colours::grey);
+        eqSliders[i].setEnabled(false);
+        addAndMakeVisible(eqSliders[i]);
+
+        eqButtons[i].setButtonText("EQ Toggle " + juce::String(i + 1));
+        eqButtons[i].setClickingTogglesState(true);
+        eqButtons[i].onClick = [this, i] { handleToggleButtonClicked(i); };
+        eqButtons[i].setColour(juce::TextButton::buttonColourId, juce::Colours::darkgrey);
+        addAndMakeVisible(eqButtons[i]);
+
+        eqSliders[i].onValueChange = [this, i]
+        {
+            if (audioProcessor.getEQMode() == i + 1)
+                setEQValue(i, (float) eqSliders[i].getValue());
+        };
+    }
+
+    // Show the EQ section selected in the saved state
+    const auto activeEQ = audioProcessor.getEQMode() - 1;
+
+    if (juce::isPositiveAndBelow(activeEQ, 3))
+    {
+        eqSliders[activeEQ].setValue(audioProcessor.getParameters().getRawParameterValue(eqParameterIDs[activeEQ])->load(),
+                                     juce::dontSendNotification);
+        eqButtons[activeEQ].setToggleState(true, juce::dontSendNotification);
+        showActiveEQ(activeEQ);
+    }
+
+    // Output meter and spectrum
+    addAndMakeVisible(levelMeter);
+    addAndMakeVisible(spectrumDisplay);
+    analysisSamples.resize(4096);
+
+    if (RealtimeChecks::enabled)
+    {
+        realtimeLabel.setJustificationType(juce::Justification::centredRight);
+        realtimeLabel.setColour(juce::Label::textColourId, juce::Colours::orange);
+        addAndMakeVisible(realtimeLabel);
+    }
+
+    audioProcessor.getAnalysisFeed().setEnabled(true);
+    startTimerHz(30);
+
+    // The background covers everything, so nothing behind the editor is drawn
+    setOpaque(true);
+    setControlsBufferedToImage(true);
+    setSize(900, 675);
+}
+
+VinylAudioProcessorEditor::~VinylAudioProcessorEditor()
+{
+    stopTimer();
+    audioProcessor.getAnalysisFeed().setEnabled(false);
+
+    // Knobs design (should be implemented)
+    saturationKnob.setLookAndFeel(nullptr);
+    wobbleKnob.setLookAndFeel(nullptr);
+}
+
+//==============================================================================
+
+void VinylAudioProcessorEditor::paint(juce::Graphics& g)
+{
+    g.drawImage(background, getLocalBounds().toFloat());
+}
+
+void VinylAudioProcessorEditor::renderBackground()
+{
+    const auto scale = juce::Component::getApproximateScaleFactorForComponent(this);
+
+    background = juce::Image(juce::Image::RGB,
+                             juce::jmax(1, juce::roundToInt((float) getWidth() * scale)),
+                             juce::jmax(1, juce::roundToInt((float) getHeight() * scale)),
+                             false);
+
+    juce::Graphics g(background);
+    g.addTransform(juce::AffineTransform::scale(scale));
+
+    g.fillAll(juce::Colours::black);
+    g.setColour(juce::Colours::white);
+
+    // Llines for 2x2 grid
+    int remainingWidth = getWidth() - 130;
+    int remainingHeight = getHeight() - 100;
+    int quadrantWidth = remainingWidth / 2;
+    int quadrantHeight = remainingHeight / 2;
+
+    g.drawLine(110, 50 + quadrantHeight, 110 + remainingWidth, 50 + quadrantHeight, 2.0f);
+    g.drawLine(110 + quadrantWidth, 50, 110 + quadrantWidth, 50 + remainingHeight, 2.0f);
+}
+
+void VinylAudioProcessorEditor::resized()
+{
+    renderBackground();
+
+    // Volume slider
+    volumeSlider.setBounds(10, 50, 80, getHeight() - 100);
+    levelMeter.setBounds(92, 50, 14, getHeight() - 100);
+    realtimeLabel.setBounds(getWidth() - 410, 15, 400, 20);
+
+    // Quadrants dimensions
+    int quadrantWidth = (getWidth() - 130) / 2;
+    int quadrantHeight = (getHeight() - 100) / 2;
+    int xOffset = 110;
+    int yOffset = 50;
+
+    // Vinyl crackle control (top-left quadrant)
+    const int crackleMargin = 10;
+    crackleLabel.setBounds(xOffset, yOffset, quadrantWidth - crackleMargin, 20);
+    crackleComboBox.setBounds(xOffset, yOffset + 30, quadrantWidth - crackleMargin, 30);
+
+    // Spectrum, below the crackle control
+    spectrumDisplay.setBounds(xOffset, yOffset + 70, quadrantWidth - crackleMargin, quadrantHeight - 80);
+
+    // Saturation knob (bottom-left quadrant)
+    int saturationYOffset = yOffset + quadrantHeight + 10;
+    int knobWidth = quadrantWidth / 2; // Half of the quadrant width
+    saturationLabel.setBounds(xOffset, saturationYOffset, quadrantWidth, 20);
+    saturationKnob.setBounds(xOffset + (quadrantWidth - knobWidth) / 2, saturationYOffset + 30, knobWidth, knobWidth);
+
+    // Wobble knob (bottom-right quadrant)
+    int wobbleXOffset = xOffset + quadrantWidth + 10; // Start at the bottom-right quadrant
+    wobbleLabel.setBounds(wobbleXOffset, saturationYOffset, quadrantWidth, 20);
+    wobbleKnob.setBounds(wobbleXOffset + (quadrantWidth - knobWidth) / 2, saturationYOffset + 30, knobWidth, knobWidth);
+
+    // EQ sliders and buttons (top-right quadrant)
+    int sliderWidth = quadrantWidth / 3;
+    int sliderHeight = quadrantHeight - 50;
+
+    for (int i = 0; i < 3; ++i)
+    {
+        eqSliders[i].setBounds(110 + quadrantWidth + i * sliderWidth, 50, sliderWidth, sliderHeight);
+        eqButtons[i].setBounds(110 + quadrantWidth + i * sliderWidth + 10, 50 + sliderHeight + 10, sliderWidth - 20, 30);
+    }
+}
+
+void VinylAudioProcessorEditor::setControlsBufferedToImage(bool shouldBeBuffered)
+{
+    volumeSlider.setBufferedToImage(shouldBeBuffered);
+    saturationKnob.setBufferedToImage(shouldBeBuffered);
+    wobbleKnob.setBufferedToImage(shouldBeBuffered);
+
+    for (auto& slider : eqSliders)
+        slider.setBufferedToImage(shouldBeBuffered);
+}
+
+//==============================================================================
+
+void VinylAudioProcessorEditor::timerCallback()
+{
+    auto& feed = audioProcessor.getAnalysisFeed();
+
+    // Loudest peak and mean power of every block since the last tick
+    AnalysisFeed::Levels levels, blockLevels;
+    int numBlocks = 0;
+
+    while (feed.readLevels(&blockLevels, 1) == 1)
+    {
+        levels.numChannels = blockLevels.numChannels;
+
+        for (int channel = 0; channel < blockLevels.numChannels; ++channel)
+        {
+            const auto i = (size_t) channel;
+            levels.peak[i] = juce::jmax(levels.peak[i], blockLevels.peak[i]);
+            levels.rms[i] += blockLevels.rms[i] * blockLevels.rms[i];
+        }
+
+        ++numBlocks;
+    }
+
+    for (auto& rms : levels.rms)
+        rms = std::sqrt(rms / (float) juce::jmax(1, numBlocks));
+
+    levelMeter.setLevels(levels);
+
+    for (;;)
+    {
+        const auto numSamples = feed.readSamples(analysisSamples.data(), (int) analysisSamples.size());
+
+        if (numSamples == 0)
+            break;
+
+        spectrumDisplay.pushSamples(analysisSamples.data(), numSamples, feed.getSampleRate());
+    }
+
+    spectrumDisplay.update();
+    updateEQResponse();
+
+    if (RealtimeChecks::enabled && --realtimeLabelCountdown <= 0)
+    {
+        realtimeLabelCountdown = 15;
+        updateRealtimeLabel();
+    }
+}
+
+void VinylAudioProcessorEditor::updateRealtimeLabel()
+{
+    const auto p99 = audioProcessor.getBlockTimes().getPercentile(0.99);
+    juce::String text;
+
+    text << "RT violations: " << RealtimeChecks::getNumViolations() << "   p99 block: ";
+
+    if (p99 == 0.0)
+        text << "-";
+    else if (std::isinf(p99))
+        text << "over 200 %";
+    else
+        text << "under " << juce::String(p99 * 100.0, 2) << " %";
+
+    // setText() only repaints the label, and only when the text changed
+    realtimeLabel.setText(text, juce::dontSendNotification);
+}
+
+void VinylAudioProcessorEditor::updateEQResponse()
+{
+    using EQ = VinylEQ<double>;
+
+    const auto sampleRate = audioProcessor.getSampleRate() > 0.0 ? audioProcessor.getSampleRate() : 44100.0;
+    std::array<float, 3> values;
+
+    for (size_t i = 0; i < values.size(); ++i)
+        values[i] = audioProcessor.getParameters().getRawParameterValue(eqParameterIDs[i])->load();
+
+    if (values == shownEQValues && sampleRate == shownEQSampleRate)
+        return;
+
+    shownEQValues = values;
+    shownEQSampleRate = sampleRate;
+
+    // Controls are in slider order; a control at 0 is out of the cascade
+    std::array<BiquadCoefficients<double>, EQ::numControls * EQ::maxSectionsPerControl> sections;
+    int numSections = 0;
+
+    for (int i = 0; i < EQ::numControls; ++i)
+    {
+        if (values[(size_t) i] <= 0.0f)
+            continue;
+
+        EQ::design((EQ::Control) i, sampleRate, values[(size_t) i], sections.data() + numSections);
+        numSections += EQ::getNumSections((EQ::Control) i);
+    }
+
+    spectrumDisplay.setEQResponse(sections.data(), numSections, sampleRate);
+}
+
+//==============================================================================
+
+void VinylAudioProcessorEditor::handleToggleButtonClicked(int buttonIndex)
+{
+    showActiveEQ(buttonIndex);
+    audioProcessor.setEQMode(buttonIndex + 1);
+
+    for (int i = 0; i < 3; ++i)
+        if (i != buttonIndex)
+            setEQValue(i, 0.0f);
+
+    setEQValue(buttonIndex, (float) eqSliders[buttonIndex].getValue());
+}
+
+void VinylAudioProcessorEditor::showActiveEQ(int buttonIndex)
+{
+    for (int i = 0; i < 3; ++i)
+    {
+        if (i != buttonIndex)
+        {
+            eqButtons[i].setToggleState(false, juce::dontSendNotification);
+            eqSliders[i].setEnabled(false);
+            eqSliders[i].setColour(juce::Slider::thumbColourId, juce::Colours::darkgrey);
+            eqSliders[i].setColour(juce::Slider::trackColourId, juce::Colours::grey);
+            eqButtons[i].setColour(juce::TextButton::buttonColourId, juce::Colours::darkgrey);
+        }
+    }
+
+    eqSliders[buttonIndex].setEnabled(true);
+    eqSliders[buttonIndex].setColour(juce::Slider::thumbColourId, juce::Colours::green);
+    eqSliders[buttonIndex].setColour(juce::Slider::trackColourId, juce::Colours::lightgreen);
+    eqButtons[buttonIndex].setColour(juce::TextButton::buttonColourId, juce::Colours::green);
+}
+
+void VinylAudioProcessorEditor::setEQValue(int index, float value)
+{
+    if (index == 0)
+        audioProcessor.setFirstEQSliderValue(value);
+    else if (index == 1)
+        audioProcessor.setLowCutValue(value);
+    else if (index == 2)
+        audioProcessor.setHighCutValue(value);
+}
+
+//==============================================================================
+
+// The processor's editor factory lives here, so VinylDSP builds without the editor
+bool VinylAudioProcessor::hasEditor() const
+{
+    return true;
+}
+
+juce::AudioProcessorEditor* VinylAudioProcessor::createEditor()
+{
+    return new VinylAudioProcessorEditor(*this);
+}
@@ -1,49 +1,85 @@
-#pragma once
-
-#include <JuceHeader.h>
-#include "PluginProcessor.h"
-
-//==============================================================================
-class VinylAudioProcessorEditor : public juce::AudioProcessorEditor
-{
-public:
-    VinylAudioProcessorEditor(VinylAudioProcessor&);
-    ~VinylAudioProcessorEditor() override;
-
-    //==============================================================================
-    void paint(juce::Graphics&) override;
-    void resized() override;
-
-private:
-    VinylAudioProcessor& audioProcessor;
-
-    // Volume slider
-    juce::Slider volumeSlider;
-
-    // EQ sliders and buttons
-    juce::Slider eqSliders[3];
-    juce::TextButton eqButtons[3];
-
-    // Crackling control
-    juce::ComboBox crackleComboBox;
-    juce::Label crackleLabel;
-
-    // Distortion/Saturation control
-    juce::Slider saturationKnob;
-    juce::Label saturationLabel;
-
-    // Wobble Effect control
-    juce::Slider wobbleKnob;
-    juce::Label wobbleLabel;
-
-    // LookAndFeel
-    juce::LookAndFeel_V4 lookAndFeelV4;
-
-    // Attachments
-    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> volumeAttachment;
-
-    // Handle button clicks
-    void handleToggleButtonClicked(int buttonIndex);
-
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VinylAudioProcessorEditor)
-};
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include "LevelMeter.h"
+#include "SpectrumDisplay.h"
+
+//==============================================================================
+class VinylAudioProcessorEditor : public juce::AudioProcessorEditor
+                                , private juce::Timer
+{
+public:
+    VinylAudioProcessorEditor(VinylAudioProcessor&);
+    ~VinylAudioProcessorEditor() override;
+
+    //==============================================================================
+    void paint(juce::Graphics&) override;
+    void resized() override;
+
+    // The knobs and sliders are buffered to images by default, so repainting
+    // the editor around them copies pixels instead of redrawing them
+    void setControlsBufferedToImage(bool shouldBeBuffered);
+
+private:
+    VinylAudioProcessor& audioProcessor;
+
+    // Black fill and quadrant grid, rendered in resized() at the display's
+    // scale. paint() only copies the part of it being repainted.
+    juce::Image background;
+    void renderBackground();
+
+    // Volume slider
+    juce::Slider volumeSlider;
+
+    // EQ sliders and buttons
+    juce::Slider eqSliders[3];
+    juce::TextButton eqButtons[3];
+
+    // Crackling control
+    juce::ComboBox crackleComboBox;
+    juce::Label crackleLabel;
+
+    // Distortion/Saturation control
+    juce::Slider saturationKnob;
+    juce::Label saturationLabel;
+
+    // Wobble Effect control
+    juce::Slider wobbleKnob;
+    juce::Label wobbleLabel;
+
+    // Output meter and spectrum, fed from the processor's AnalysisFeed on a
+    // timer. They repaint themselves; the rest of the editor stays as it is.
+    LevelMeter levelMeter;
+    SpectrumDisplay spectrumDisplay;
+
+    std::vector<float> analysisSamples;
+    std::array<float, 3> shownEQValues { -1.0f, -1.0f, -1.0f };
+    double shownEQSampleRate = 0.0;
+
+    // Violation count and 99th percentile block time, in VINYL_RT_CHECKS builds only
+    juce::Label realtimeLabel;
+    int realtimeLabelCountdown = 0;
+
+    void timerCallback() override;
+    void updateEQResponse();    // Only when an EQ value or the sample rate changed
+    void updateRealtimeLabel();
+
+    // LookAndFeel
+    juce::LookAndFeel_V4 lookAndFeelV4;
+
+    // Attachments
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> volumeAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> saturationAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> wobbleAttachment;
+
+    // Parameters behind the three EQ sliders, in slider order
+    static constexpr const char* eqParameterIDs[3] { "FIRST_EQ", "LOW_CUT", "HIGH_CUT" };
+
+    // Handle button clicks
+    void handleToggleButtonClicked(int buttonIndex);
+    void showActiveEQ(int buttonIndex);         // Colours and enables the controls only
+    void setEQValue(int index, float value);    // Sends one slider's value to the processor
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VinylAudioProcessorEditor)
+};
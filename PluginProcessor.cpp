@@ -1,307 +1,427 @@
-#include "PluginProcessor.h"
-#include "PluginEditor.h"
-
-//==============================================================================
-
-VinylAudioProcessor::VinylAudioProcessor()
-#ifndef JucePlugin_PreferredChannelConfigurations
-    : AudioProcessor(BusesProperties()
-#if ! JucePlugin_IsMidiEffect
-#if ! JucePlugin_IsSynth
-        .withInput("Input", juce::AudioChannelSet::stereo(), true)
-#endif
-        .withOutput("Output", juce::AudioChannelSet::stereo(), true)
-#endif
-    ),
-    parameters(*this, nullptr, "PARAMETERS",
-        {
-            std::make_unique<juce::AudioParameterFloat>("VOLUME", "Volume", 0.0f, 1.0f, 0.5f)
-        })
-#endif
-{
-}
-
-VinylAudioProcessor::~VinylAudioProcessor()
-{
-}
-
-//==============================================================================
-
-void VinylAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
-{
-    juce::dsp::ProcessSpec spec;
-    spec.sampleRate = sampleRate;
-    spec.maximumBlockSize = samplesPerBlock;
-    spec.numChannels = getTotalNumOutputChannels();
-
-    lowCutFilter.prepare(spec);  // Low-cut filter
-    highCutFilter.prepare(spec); // High-cut filter
-    updateLowCutFilter();        // Update low-cut initially
-    updateHighCutFilter();       // Update high-cut initially
-
-    subBassFilter.prepare(spec);    // Sub-Bass filter
-    lowMidFilter.prepare(spec);     // Low-Mid filter
-    highFreqFilter.prepare(spec);   // High-Frequency filter
-    updateFirstEQSlider();          // Update all filters initially
-}
-
-void VinylAudioProcessor::releaseResources()
-{
-    // Free any resources after playback stops here
-}
-
-void VinylAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
-{
-    juce::ScopedNoDenormals noDenormals;
-    auto totalNumInputChannels = getTotalNumInputChannels();
-    auto totalNumOutputChannels = getTotalNumOutputChannels();
-
-    // Clear the output buffer if necessary
-    for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
-        buffer.clear(i, 0, buffer.getNumSamples());
-
-    // Get volume parameter
-    auto* volume = parameters.getRawParameterValue("VOLUME");
-
-    // Apply volume
-    for (int channel = 0; channel < totalNumInputChannels; ++channel)
-    {
-        auto* channelData = buffer.getWritePointer(channel);
-        for (int sample = 0; sample < buffer.getNumSamples(); ++sample)
-        {
-            channelData[sample] *= *volume;
-        }
-    }
-
-    // Apply the low-cut filter
-    if (lowCutValue > 0.0f)
-    {
-        juce::dsp::AudioBlock<float> block(buffer);
-        lowCutFilter.process(juce::dsp::ProcessContextReplacing<float>(block));
-    }
-
-    // Apply the high-cut filter
-    if (highCutValue > 0.0f)
-    {
-        juce::dsp::AudioBlock<float> block(buffer);
-        highCutFilter.process(juce::dsp::ProcessContextReplacing<float>(block));
-    }
-
-    // Apply the First EQ Slider
-    if (firstEQValue > 0.0f)
-    {
-        juce::dsp::AudioBlock<float> block(buffer);
-
-        subBassFilter.process(juce::dsp::ProcessContextReplacing<float>(block));
-        lowMidFilter.process(juce::dsp::ProcessContextReplacing<float>(block));
-        highFreqFilter.process(juce::dsp::ProcessContextReplacing<float>(block));
-
-    }
-}
-
-//==============================================================================
-void VinylAudioProcessor::setFirstEQSliderValue(float value)
-{
-    firstEQValue = value;
-    updateFirstEQSlider();
-}
-
-void VinylAudioProcessor::updateFirstEQSlider()
-{
-    // Sub-Bass Cut (below 80 Hz
-    if (firstEQValue == 0.0f)
-    {
-        // Bypass when slider is at 0
-        auto coefficients = juce::dsp::IIR::Coefficients<float>::makeHighPass(getSampleRate(), 80.0f);  // No cut at 80Hz
-        *subBassFilter.get<0>().state = *coefficients;
-    }
-    else
-    {
-        float subBassCutGain = 1.0f - std::pow(firstEQValue, 2.0f) * 0.3f;  // Non-linear cut
-        auto coefficients = juce::dsp::IIR::Coefficients<float>::makeHighPass(getSampleRate(), 80.0f, subBassCutGain);
-        *subBassFilter.get<0>().state = *coefficients;
-    }
-
-    // Low-Mid Boost (150 Hz - 500 Hz)
-    if (firstEQValue == 0.0f)
-    {
-        // Bypass when the slider is at 0
-        auto coefficients = juce::dsp::IIR::Coefficients<float>::makeAllPass(getSampleRate(),325.0f);  // No boost
-        *lowMidFilter.get<0>().state = *coefficients;
-        return;
-    }
-    else
-    {
-        // Apply a boost based on slider value
-        float lowMidBoostGain = 1.0f + std::pow(firstEQValue, 2.0f) * 0.5f;
-        auto coefficients = juce::dsp::IIR::Coefficients<float>::makePeakFilter(getSampleRate(), 325.0f, 1.0f, lowMidBoostGain);  // Peak filter to boost Low-Mids
-        *lowMidFilter.get<0>().state = *coefficients;
-    }
-
-    // High-Frequency Roll-Off (above 10 kHz)
-    if (firstEQValue == 0.0f)
-    {
-        // Bypass when slider is at 0
-        auto coefficients = juce::dsp::IIR::Coefficients<float>::makeLowPass(getSampleRate(), 20000.0f);
-        *highFreqFilter.get<0>().state = *coefficients;
-    }
-    else
-    {
-        float highFreqRollOffGain = 1.0f - std::pow(firstEQValue, 2.0f) * 0.15f;
-        auto coefficients = juce::dsp::IIR::Coefficients<float>::makeLowPass(getSampleRate(), 10000.0f, highFreqRollOffGain);
-        *highFreqFilter.get<0>().state = *coefficients;
-    }
-}
-
-
-
-//==============================================================================
-
-void VinylAudioProcessor::setLowCutValue(float value)
-{
-    lowCutValue = value;
-    updateLowCutFilter();
-}
-
-void VinylAudioProcessor::updateLowCutFilter()
-{
-    if (lowCutValue == 0.0f)
-    {
-        auto coefficients = juce::dsp::IIR::Coefficients<float>::makeHighPass(getSampleRate(), 20.0f);  // Bypass filter
-        *lowCutFilter.get<0>().state = *coefficients;
-        return;
-    }
-
-    float cutoffFrequency = 80.0f + lowCutValue * 200.0f;  // 80Hz - 280Hz
-    auto coefficients = juce::dsp::IIR::Coefficients<float>::makeHighPass(getSampleRate(), cutoffFrequency);
-    *lowCutFilter.get<0>().state = *coefficients;
-}
-
-void VinylAudioProcessor::setHighCutValue(float value)
-{
-    highCutValue = value;
-    updateHighCutFilter();
-}
-
-void VinylAudioProcessor::updateHighCutFilter()
-{
-    if (highCutValue == 0.0f)
-    {
-        auto coefficients = juce::dsp::IIR::Coefficients<float>::makeLowPass(getSampleRate(), 20000.0f);  // Bypass filter
-        *highCutFilter.get<0>().state = *coefficients;
-        return;
-    }
-
-    float cutoffFrequency = 10000.0f - highCutValue * 5000.0f;  // 10kHz - 5kHz
-    auto coefficients = juce::dsp::IIR::Coefficients<float>::makeLowPass(getSampleRate(), cutoffFrequency);
-    *highCutFilter.get<0>().state = *coefficients;
-}
-
-//==============================================================================
-
-#ifndef JucePlugin_PreferredChannelConfigurations
-bool VinylAudioProcessor::isBusesLayoutSupported(const BusesLayout& layouts) const
-{
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-        && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
-        return false;
-
-#if !JucePlugin_IsSynth
-    if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
-        return false;
-#endif
-
-    return true;
-}
-#endif
-
-//==============================================================================
-
-bool VinylAudioProcessor::hasEditor() const
-{
-    return true;
-}
-
-juce::AudioProcessorEditor* VinylAudioProcessor::createEditor()
-{
-    return new VinylAudioProcessorEditor(*this);
-}
-
-//==============================================================================
-
-const juce::String VinylAudioProcessor::getName() const
-{
-    return JucePlugin_Name;
-}
-
-bool VinylAudioProcessor::acceptsMidi() const
-{
-#if JucePlugin_WantsMidiInput
-    return true;
-#else
-    return false;
-#endif
-}
-
-bool VinylAudioProcessor::producesMidi() const
-{
-#if JucePlugin_ProducesMidiOutput
-    return true;
-#else
-    return false;
-#endif
-}
-
-bool VinylAudioProcessor::isMidiEffect() const
-{
-#if JucePlugin_IsMidiEffect
-    return true;
-#else
-    return false;
-#endif
-}
-
-double VinylAudioProcessor::getTailLengthSeconds() const
-{
-    return 0.0;
-}
-
-int VinylAudioProcessor::getNumPrograms()
-{
-    return 1;
-}
-
-int VinylAudioProcessor::getCurrentProgram()
-{
-    return 0;
-}
-
-void VinylAudioProcessor::setCurrentProgram(int index)
-{
-}
-
-const juce::String VinylAudioProcessor::getProgramName(int index)
-{
-    return {};
-}
-
-void VinylAudioProcessor::changeProgramName(int index, const juce::String& newName)
-{
-}
-
-//==============================================================================
-
-void VinylAudioProcessor::getStateInformation(juce::MemoryBlock& destData)
-{
-}
-
-void VinylAudioProcessor::setStateInformation(const void* data, int sizeInBytes)
-{
-}
-
-//==============================================================================
-
-juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
-{
-    return new VinylAudioProcessor();
-}
+#include "PluginProcessor.h"
+
+//==============================================================================
+
+namespace
+{
+    // Parameters that can change the latency, see parameterChanged()
+    const char* const latencyParameterIDs[] { "LINEAR_PHASE_EQ", "SATURATION", "OVERSAMPLING", "OVERSAMPLING_FILTER", "WOBBLE", "QUALITY" };
+
+    // How often the message thread looks for a latency change
+    constexpr int latencyPollHz = 20;
+
+    // Saved state: magic, format version, then the parameter tree in
+    // ValueTree's binary format. Bump the version when a change needs migrating.
+    constexpr juce::uint32 stateMagic = 0x4c594e56; // "VNYL"
+    constexpr int stateVersion = 1;
+}
+
+const std::array<VinylAudioProcessor::CracklePreset, 4> VinylAudioProcessor::cracklePresets
+{ {
+    { "No Crackle",     0.0f,  0.0f },
+    { "Subtle Crackle", 2.0f,  0.05f },
+    { "Medium Crackle", 8.0f,  0.12f },
+    { "Heavy Crackle",  25.0f, 0.25f }
+} };
+
+VinylAudioProcessor::VinylAudioProcessor()
+#ifndef JucePlugin_PreferredChannelConfigurations
+    : AudioProcessor(BusesProperties()
+#if ! JucePlugin_IsMidiEffect
+#if ! JucePlugin_IsSynth
+        .withInput("Input", juce::AudioChannelSet::stereo(), true)
+#endif
+        .withOutput("Output", juce::AudioChannelSet::stereo(), true)
+#endif
+    ),
+    parameters(*this, nullptr, "PARAMETERS",
+        {
+            std::make_unique<juce::AudioParameterFloat>("VOLUME", "Volume", 0.0f, 1.0f, 0.5f),
+            std::make_unique<juce::AudioParameterChoice>("EQ_MODE", "EQ Mode",
+                juce::StringArray { "Off", "Vinyl EQ", "Low Cut", "High Cut" }, 0),
+            std::make_unique<juce::AudioParameterFloat>("FIRST_EQ", "Vinyl EQ", 0.0f, 1.0f, 0.0f),
+            std::make_unique<juce::AudioParameterFloat>("LOW_CUT", "Low Cut", 0.0f, 1.0f, 0.0f),
+            std::make_unique<juce::AudioParameterFloat>("HIGH_CUT", "High Cut", 0.0f, 1.0f, 0.0f),
+            std::make_unique<juce::AudioParameterBool>("LINEAR_PHASE_EQ", "Linear Phase EQ", false),
+            std::make_unique<juce::AudioParameterFloat>("CRACKLE_DENSITY", "Crackle Density",
+                juce::NormalisableRange<float>(0.0f, 100.0f, 0.0f, 0.4f), cracklePresets[0].density),
+            std::make_unique<juce::AudioParameterFloat>("CRACKLE_LEVEL", "Crackle Level", 0.0f, 1.0f, cracklePresets[0].level),
+            std::make_unique<juce::AudioParameterFloat>("SATURATION", "Saturation", 0.0f, 1.0f, 0.0f),
+            std::make_unique<juce::AudioParameterChoice>("OVERSAMPLING", "Oversampling",
+                juce::StringArray { "1x", "2x", "4x" }, 1),
+            std::make_unique<juce::AudioParameterChoice>("OVERSAMPLING_FILTER", "Oversampling Filter",
+                juce::StringArray { "Minimum Latency", "Linear Phase" }, 0),
+            std::make_unique<juce::AudioParameterFloat>("WOBBLE", "Wobble", 0.0f, 1.0f, 0.0f),
+            std::make_unique<juce::AudioParameterBool>("WOBBLE_LINK", "Wobble Link", true),
+            std::make_unique<juce::AudioParameterChoice>("QUALITY", "Quality",
+                juce::StringArray { "Eco", "Normal", "High" }, 1)
+        })
+#endif
+{
+    volumeParameter = parameters.getRawParameterValue("VOLUME");
+    eqModeParameter = parameters.getRawParameterValue("EQ_MODE");
+    firstEQParameter = parameters.getRawParameterValue("FIRST_EQ");
+    lowCutParameter = parameters.getRawParameterValue("LOW_CUT");
+    highCutParameter = parameters.getRawParameterValue("HIGH_CUT");
+    linearPhaseEQParameter = parameters.getRawParameterValue("LINEAR_PHASE_EQ");
+    crackleDensityParameter = parameters.getRawParameterValue("CRACKLE_DENSITY");
+    crackleLevelParameter = parameters.getRawParameterValue("CRACKLE_LEVEL");
+    saturationParameter = parameters.getRawParameterValue("SATURATION");
+    oversamplingParameter = parameters.getRawParameterValue("OVERSAMPLING");
+    oversamplingFilterParameter = parameters.getRawParameterValue("OVERSAMPLING_FILTER");
+    wobbleParameter = parameters.getRawParameterValue("WOBBLE");
+    wobbleLinkParameter = parameters.getRawParameterValue("WOBBLE_LINK");
+    qualityParameter = parameters.getRawParameterValue("QUALITY");
+
+    saturationOn = saturationParameter->load() > 0.0f;
+    wobbleOn = wobbleParameter->load() > 0.0f;
+
+    for (auto* id : latencyParameterIDs)
+        parameters.addParameterListener(id, this);
+
+    startTimerHz(latencyPollHz);
+}
+
+VinylAudioProcessor::~VinylAudioProcessor()
+{
+    stopTimer();
+
+    for (auto* id : latencyParameterIDs)
+        parameters.removeParameterListener(id, this);
+}
+
+//==============================================================================
+
+void VinylAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
+{
+    juce::dsp::ProcessSpec spec;
+    spec.sampleRate = sampleRate;
+    spec.maximumBlockSize = samplesPerBlock;
+    spec.numChannels = getTotalNumOutputChannels();
+
+    if (isUsingDoublePrecision())
+        doubleChain.prepare(spec, getSettings(), randomSeed);
+    else
+        floatChain.prepare(spec, getSettings(), randomSeed);
+
+    analysisFeed.prepare(sampleRate);
+    updateLatency();
+}
+
+void VinylAudioProcessor::releaseResources()
+{
+    // Free any resources after playback stops here
+}
+
+template <typename SampleType>
+void VinylAudioProcessor::processChain(VinylChain<SampleType>& chain, juce::AudioBuffer<SampleType>& buffer) noexcept
+{
+    RealtimeChecks::ScopedAudioThread audioThread;
+    const auto startTicks = RealtimeChecks::enabled ? juce::Time::getHighResolutionTicks() : 0;
+
+    juce::ScopedNoDenormals noDenormals;
+    auto totalNumInputChannels = getTotalNumInputChannels();
+    auto totalNumOutputChannels = getTotalNumOutputChannels();
+
+    // Clear the output buffer if necessary
+    for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
+        buffer.clear(i, 0, buffer.getNumSamples());
+
+    // Parameters are read once per block
+    chain.setSettings(getSettings());
+
+    if (! chain.process(buffer, totalNumInputChannels))
+        ++skippedBlocks;
+
+    analysisFeed.push(buffer);
+
+    if constexpr (RealtimeChecks::enabled)
+    {
+        const auto elapsed = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+        const auto duration = buffer.getNumSamples() / getSampleRate();
+
+        if (duration > 0.0)
+            blockTimes.add(elapsed / duration);
+    }
+}
+
+void VinylAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer&)
+{
+    processChain(floatChain, buffer);
+}
+
+void VinylAudioProcessor::processBlock(juce::AudioBuffer<double>& buffer, juce::MidiBuffer&)
+{
+    processChain(doubleChain, buffer);
+}
+
+bool VinylAudioProcessor::supportsDoublePrecisionProcessing() const
+{
+    return true;
+}
+
+VinylSettings VinylAudioProcessor::getSettings() const noexcept
+{
+    VinylSettings settings;
+    settings.volume = volumeParameter->load();
+    settings.firstEQ = firstEQParameter->load();
+    settings.lowCut = lowCutParameter->load();
+    settings.highCut = highCutParameter->load();
+    settings.linearPhaseEQ = linearPhaseEQParameter->load() > 0.5f;
+    settings.crackleDensity = crackleDensityParameter->load();
+    settings.crackleLevel = crackleLevelParameter->load();
+    settings.saturation = saturationParameter->load();
+    settings.oversampling = (int) oversamplingParameter->load();
+    settings.oversamplingFilter = (int) oversamplingFilterParameter->load();
+    settings.wobble = wobbleParameter->load();
+    settings.wobbleLinked = wobbleLinkParameter->load() > 0.5f;
+
+    // Offline renders always get the best quality
+    const auto quality = isNonRealtime() ? VinylQuality::high : (VinylQuality) (int) qualityParameter->load();
+    return applyQuality(settings, quality);
+}
+
+void VinylAudioProcessor::setNonRealtime(bool shouldBeNonRealtime) noexcept
+{
+    AudioProcessor::setNonRealtime(shouldBeNonRealtime);
+
+    // The quality mode, and with it the latency, follows
+    latencyChanged = true;
+}
+
+//==============================================================================
+void VinylAudioProcessor::setFirstEQSliderValue(float value)
+{
+    auto* parameter = parameters.getParameter("FIRST_EQ");
+    parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+}
+
+void VinylAudioProcessor::setLowCutValue(float value)
+{
+    auto* parameter = parameters.getParameter("LOW_CUT");
+    parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+}
+
+void VinylAudioProcessor::setHighCutValue(float value)
+{
+    auto* parameter = parameters.getParameter("HIGH_CUT");
+    parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+}
+
+void VinylAudioProcessor::setEQMode(int mode)
+{
+    auto* parameter = parameters.getParameter("EQ_MODE");
+    parameter->setValueNotifyingHost(parameter->convertTo0to1((float) mode));
+}
+
+int VinylAudioProcessor::getEQMode() const
+{
+    return (int) eqModeParameter->load();
+}
+
+void VinylAudioProcessor::setCracklePreset(int index)
+{
+    if (! juce::isPositiveAndBelow(index, (int) cracklePresets.size()))
+        return;
+
+    auto setParameter = [this](const char* id, float value)
+    {
+        auto* parameter = parameters.getParameter(id);
+        parameter->beginChangeGesture();
+        parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+        parameter->endChangeGesture();
+    };
+
+    setParameter("CRACKLE_DENSITY", cracklePresets[(size_t) index].density);
+    setParameter("CRACKLE_LEVEL", cracklePresets[(size_t) index].level);
+}
+
+int VinylAudioProcessor::getCracklePresetIndex() const
+{
+    for (size_t i = 0; i < cracklePresets.size(); ++i)
+        if (juce::approximatelyEqual(crackleDensityParameter->load(), cracklePresets[i].density)
+            && juce::approximatelyEqual(crackleLevelParameter->load(), cracklePresets[i].level))
+            return (int) i;
+
+    return -1;
+}
+
+void VinylAudioProcessor::parameterChanged(const juce::String& parameterID, float newValue)
+{
+    // May be called on the audio thread: no locks, no messages, just the flag.
+    // Checked as audio thread code wherever it runs.
+    RealtimeChecks::ScopedAudioThread audioThread;
+
+    // Saturation and wobble only add latency while they are above 0, so
+    // automating them only matters when they cross it
+    if (parameterID == "SATURATION")
+    {
+        if (saturationOn.exchange(newValue > 0.0f) == (newValue > 0.0f))
+            return;
+    }
+    else if (parameterID == "WOBBLE")
+    {
+        if (wobbleOn.exchange(newValue > 0.0f) == (newValue > 0.0f))
+            return;
+    }
+
+    latencyChanged = true;
+}
+
+void VinylAudioProcessor::timerCallback()
+{
+    if (latencyChanged.exchange(false))
+        updateLatency();
+}
+
+void VinylAudioProcessor::updateLatency()
+{
+    const auto settings = getSettings();
+    const auto latency = isUsingDoublePrecision() ? doubleChain.getLatencyInSamples(settings)
+                                                   : floatChain.getLatencyInSamples(settings);
+    const auto latencySamples = juce::roundToInt(latency);
+
+    if (latencySamples != getLatencySamples())
+        setLatencySamples(latencySamples);
+}
+
+//==============================================================================
+
+#ifndef JucePlugin_PreferredChannelConfigurations
+bool VinylAudioProcessor::isBusesLayoutSupported(const BusesLayout& layouts) const
+{
+    // Any layout, from mono to surround, ambisonics or discrete channels, up to maxChannels
+    const auto numChannels = layouts.getMainOutputChannelSet().size();
+
+    if (numChannels < 1 || numChannels > maxChannels)
+        return false;
+
+#if !JucePlugin_IsSynth
+    if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
+        return false;
+#endif
+
+    return true;
+}
+#endif
+
+//==============================================================================
+
+// hasEditor() and createEditor() are defined with the editor, in
+// PluginEditor.cpp, or in Tools/NoEditor.cpp for the tools built without it
+
+//==============================================================================
+
+const juce::String VinylAudioProcessor::getName() const
+{
+    return JucePlugin_Name;
+}
+
+bool VinylAudioProcessor::acceptsMidi() const
+{
+#if JucePlugin_WantsMidiInput
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool VinylAudioProcessor::producesMidi() const
+{
+#if JucePlugin_ProducesMidiOutput
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool VinylAudioProcessor::isMidiEffect() const
+{
+#if JucePlugin_IsMidiEffect
+    return true;
+#else
+    return false;
+#endif
+}
+
+double VinylAudioProcessor::getTailLengthSeconds() const
+{
+    // The bound the chain holds the silence bypass for, plus the EQ's decay
+    // and the longest crackle pop; the same whichever settings are live.
+    // Before prepareToPlay() there is no sample rate, so only the parts
+    // that don't depend on one.
+    const auto sampleRate = getSampleRate();
+
+    if (sampleRate <= 0.0)
+        return WowFlutter<float>::getMaximumDelaySeconds() + VinylEQ<float>::getDecaySeconds()
+             + CrackleGenerator<float>::getMaximumPopSeconds();
+
+    const auto tailSamples = isUsingDoublePrecision() ? doubleChain.getTailLengthInSamples()
+                                                      : floatChain.getTailLengthInSamples();
+    return (double) tailSamples / sampleRate;
+}
+
+int VinylAudioProcessor::getNumPrograms()
+{
+    return 1;
+}
+
+int VinylAudioProcessor::getCurrentProgram()
+{
+    return 0;
+}
+
+void VinylAudioProcessor::setCurrentProgram(int index)
+{
+}
+
+const juce::String VinylAudioProcessor::getProgramName(int index)
+{
+    return {};
+}
+
+void VinylAudioProcessor::changeProgramName(int index, const juce::String& newName)
+{
+}
+
+//==============================================================================
+
+void VinylAudioProcessor::getStateInformation(juce::MemoryBlock& destData)
+{
+    juce::MemoryOutputStream stream(destData, false);
+    stream.writeInt((int) stateMagic);
+    stream.writeInt(stateVersion);
+    parameters.copyState().writeToStream(stream);
+}
+
+void VinylAudioProcessor::setStateInformation(const void* data, int sizeInBytes)
+{
+    juce::MemoryInputStream stream(data, (size_t) juce::jmax(0, sizeInBytes), false);
+
+    if (sizeInBytes < 8 || (juce::uint32) stream.readInt() != stateMagic)
+        return;
+
+    // State from a newer build may mean something else; keep the current settings
+    if (stream.readInt() > stateVersion)
+        return;
+
+    // Parameters missing from older states keep their defaults
+    auto state = juce::ValueTree::readFromStream(stream);
+
+    if (! state.hasType(parameters.state.getType()))
+        return;
+
+    parameters.replaceState(state);
+
+    // Report the new latency now rather than on the next timer poll. Nothing
+    // here allocates DSP memory: processBlock reads every parameter directly
+    // and redesigns the EQ from them.
+    updateLatency();
+}
+
+//==============================================================================
+
+juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
+{
+    return new VinylAudioProcessor();
+}
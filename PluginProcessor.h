@@ -1,87 +1,156 @@
-#pragma once
-
-#include <JuceHeader.h>
-
-//==============================================================================
-class VinylAudioProcessor : public juce::AudioProcessor
-#if JucePlugin_Enable_ARA
-    , public juce::AudioProcessorARAExtension
-#endif
-{
-public:
-    //==============================================================================
-    VinylAudioProcessor();
-    ~VinylAudioProcessor() override;
-
-    //==============================================================================
-    void prepareToPlay(double sampleRate, int samplesPerBlock) override;
-    void releaseResources() override;
-
-#ifndef JucePlugin_PreferredChannelConfigurations
-    bool isBusesLayoutSupported(const BusesLayout& layouts) const override;
-#endif
-
-    void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
-
-    //==============================================================================
-    juce::AudioProcessorEditor* createEditor() override;
-    bool hasEditor() const override;
-
-    //==============================================================================
-    const juce::String getName() const override;
-
-    bool acceptsMidi() const override;
-    bool producesMidi() const override;
-    bool isMidiEffect() const override;
-    double getTailLengthSeconds() const override;
-
-    //==============================================================================
-    int getNumPrograms() override;
-    int getCurrentProgram() override;
-    void setCurrentProgram(int index) override;
-    const juce::String getProgramName(int index) override;
-    void changeProgramName(int index, const juce::String& newName) override;
-
-    //==============================================================================
-    void getStateInformation(juce::MemoryBlock& destData) override;
-    void setStateInformation(const void* data, int sizeInBytes) override;
-
-    //==============================================================================
-    // Getter for accessing the parameters
-    juce::AudioProcessorValueTreeState& getParameters() { return parameters; }
-
-    // Low-Cut Filter (Second EQ slier)
-    void setLowCutValue(float value);
-    void updateLowCutFilter();
-
-    // High-Cut Filter (Third EQ slider)
-    void setHighCutValue(float value);
-    void updateHighCutFilter();
-
-    // First (Main) EQ Slider 
-    void setFirstEQSliderValue(float value); 
-    void updateFirstEQSlider();
-
-private:
-    juce::AudioProcessorValueTreeState parameters;
-
-    // Low-Cut Filter for the second slider
-    using Filter = juce::dsp::IIR::Filter<float>;
-    using FilterDuplicator = juce::dsp::ProcessorDuplicator<Filter, juce::dsp::IIR::Coefficients<float>>;
-    juce::dsp::ProcessorChain<FilterDuplicator> lowCutFilter;
-
-    // High-Cut Filter for the third slider
-    juce::dsp::ProcessorChain<FilterDuplicator> highCutFilter;
-
-    // First EQ Slider Filters
-    juce::dsp::ProcessorChain<FilterDuplicator> subBassFilter;   // Sub-Bass Cut filter (below 80Hz)
-    juce::dsp::ProcessorChain<FilterDuplicator> lowMidFilter;    // Low-Mid Boost filter (150Hz to 500Hz)
-    juce::dsp::ProcessorChain<FilterDuplicator> highFreqFilter;  // High-Frequency Roll-Off (above 10kHz)
-
-    // Values for the EQ sliders
-    float lowCutValue = 0.0f;
-    float highCutValue = 0.0f;
-    float firstEQValue = 0.0f;
-
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VinylAudioProcessor)
-};
+#pragma once
+
+#include <JuceHeader.h>
+#include "AnalysisFeed.h"
+#include "RealtimeChecks.h"
+#include "VinylChain.h"
+
+//==============================================================================
+class VinylAudioProcessor : public juce::AudioProcessor
+#if JucePlugin_Enable_ARA
+    , public juce::AudioProcessorARAExtension
+#endif
+    , private juce::AudioProcessorValueTreeState::Listener
+    , private juce::Timer
+{
+public:
+    //==============================================================================
+    VinylAudioProcessor();
+    ~VinylAudioProcessor() override;
+
+    //==============================================================================
+    void prepareToPlay(double sampleRate, int samplesPerBlock) override;
+    void releaseResources() override;
+
+#ifndef JucePlugin_PreferredChannelConfigurations
+    bool isBusesLayoutSupported(const BusesLayout& layouts) const override;
+#endif
+
+    void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock(juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override;
+
+    // Offline processing runs in the High quality mode whatever QUALITY says
+    void setNonRealtime(bool shouldBeNonRealtime) noexcept override;
+
+    //==============================================================================
+    juce::AudioProcessorEditor* createEditor() override;
+    bool hasEditor() const override;
+
+    //==============================================================================
+    const juce::String getName() const override;
+
+    bool acceptsMidi() const override;
+    bool producesMidi() const override;
+    bool isMidiEffect() const override;
+    double getTailLengthSeconds() const override;
+
+    //==============================================================================
+    int getNumPrograms() override;
+    int getCurrentProgram() override;
+    void setCurrentProgram(int index) override;
+    const juce::String getProgramName(int index) override;
+    void changeProgramName(int index, const juce::String& newName) override;
+
+    //==============================================================================
+    void getStateInformation(juce::MemoryBlock& destData) override;
+    void setStateInformation(const void* data, int sizeInBytes) override;
+
+    //==============================================================================
+    // Widest main bus accepted, in any channel layout
+    static constexpr int maxChannels = 16;
+
+    //==============================================================================
+    // Getter for accessing the parameters
+    juce::AudioProcessorValueTreeState& getParameters() { return parameters; }
+
+    // EQ setters, called from the message thread. They store the value in the
+    // APVTS; processBlock picks it up like any other automation.
+    void setLowCutValue(float value);        // Low-Cut Filter (Second EQ slider)
+    void setHighCutValue(float value);       // High-Cut Filter (Third EQ slider)
+    void setFirstEQSliderValue(float value); // First (Main) EQ Slider
+
+    // Which EQ section the editor has selected: 0 off, 1 Vinyl EQ, 2 Low Cut,
+    // 3 High Cut. Only remembered for the editor, the EQ values alone decide
+    // what is processed.
+    void setEQMode(int mode);
+    int getEQMode() const;
+
+    // Crackle presets offered by the editor, as values for CRACKLE_DENSITY and CRACKLE_LEVEL
+    struct CracklePreset
+    {
+        const char* name;
+        float density;  // Events per second
+        float level;
+    };
+
+    static const std::array<CracklePreset, 4> cracklePresets;
+
+    void setCracklePreset(int index);   // Message thread
+    int getCracklePresetIndex() const;  // -1 if the parameters don't match any preset
+
+    // Seed for the crackle events and the flutter noise, used from the next
+    // prepareToPlay. Each instance starts with a random seed; set a fixed one
+    // for repeatable renders.
+    void setRandomSeed(juce::uint32 seed) { randomSeed = seed; }
+
+    // Blocks skipped because the input was silent and the chain had nothing
+    // left to output, since construction
+    juce::int64 getNumSkippedBlocks() const noexcept { return skippedBlocks; }
+
+    // Output levels and samples for the editor's meters and spectrum. The
+    // editor switches it on while it is open.
+    AnalysisFeed& getAnalysisFeed() noexcept { return analysisFeed; }
+
+    // processBlock times since construction; only filled in VINYL_RT_CHECKS builds
+    const RealtimeChecks::BlockTimeHistogram& getBlockTimes() const noexcept { return blockTimes; }
+
+private:
+    juce::AudioProcessorValueTreeState parameters;
+
+    // Raw parameter values
+    std::atomic<float>* volumeParameter = nullptr;
+    std::atomic<float>* eqModeParameter = nullptr;
+    std::atomic<float>* firstEQParameter = nullptr;
+    std::atomic<float>* lowCutParameter = nullptr;
+    std::atomic<float>* highCutParameter = nullptr;
+    std::atomic<float>* linearPhaseEQParameter = nullptr;
+    std::atomic<float>* crackleDensityParameter = nullptr;
+    std::atomic<float>* crackleLevelParameter = nullptr;
+    std::atomic<float>* saturationParameter = nullptr;
+    std::atomic<float>* oversamplingParameter = nullptr;
+    std::atomic<float>* oversamplingFilterParameter = nullptr;
+    std::atomic<float>* wobbleParameter = nullptr;
+    std::atomic<float>* wobbleLinkParameter = nullptr;
+    std::atomic<float>* qualityParameter = nullptr;
+
+    std::atomic<juce::uint32> randomSeed { (juce::uint32) juce::Random::getSystemRandom().nextInt() };
+
+    // One chain per precision; only the one matching the host's processing
+    // precision is prepared and run
+    VinylChain<float> floatChain;
+    VinylChain<double> doubleChain;
+
+    std::atomic<juce::int64> skippedBlocks { 0 };
+
+    AnalysisFeed analysisFeed;
+    RealtimeChecks::BlockTimeHistogram blockTimes;
+
+    VinylSettings getSettings() const noexcept;
+
+    template <typename SampleType>
+    void processChain(VinylChain<SampleType>& chain, juce::AudioBuffer<SampleType>& buffer) noexcept;
+
+    // Latency depends on the EQ phase, on saturation and wobble being on at
+    // all, on the oversampling and on the quality mode. parameterChanged()
+    // may run on the audio thread, so it only raises latencyChanged, and only
+    // when one of those moves; a message thread timer polls the flag.
+    void parameterChanged(const juce::String& parameterID, float newValue) override;
+    void timerCallback() override;
+    void updateLatency();
+
+    std::atomic<bool> latencyChanged { false };
+    std::atomic<bool> saturationOn { false }, wobbleOn { false };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VinylAudioProcessor)
+};
@@ -0,0 +1,361 @@
+#include "RealtimeChecks.h"
+
+//==============================================================================
+
+juce::String RealtimeChecks::BlockTimeHistogram::toString() const
+{
+    const auto snapshot = getCounts();
+    juce::String text;
+
+    for (int bucket = 0; bucket < numBuckets; ++bucket)
+    {
+        const auto lower = bucket > 0 ? getUpperBound(bucket - 1) * 100.0 : 0.0;
+        const auto upper = getUpperBound(bucket) * 100.0;
+        const auto range = bucket < numBuckets - 1 ? juce::String(lower, 2) + " - " + juce::String(upper, 2) + " %"
+                                                   : juce::String(lower, 2) + " % and up";
+
+        text << range.paddedRight(' ', 20) << juce::String((juce::int64) snapshot[(size_t) bucket]) << juce::newLine;
+    }
+
+    return text;
+}
+
+#if ! VINYL_RT_CHECKS
+
+int RealtimeChecks::getNumViolations() noexcept                  { return 0; }
+bool RealtimeChecks::getViolation(int, Violation&) noexcept      { return false; }
+void RealtimeChecks::clearViolations() noexcept                  {}
+juce::String RealtimeChecks::describe(const Violation&)          { return {}; }
+
+#else
+
+#include <new>
+
+#if JUCE_WINDOWS
+ #include <malloc.h>
+#endif
+
+#if JUCE_LINUX || JUCE_BSD || JUCE_MAC
+ #include <execinfo.h>
+ #define VINYL_RT_BACKTRACE 1
+#else
+ #define VINYL_RT_BACKTRACE 0
+#endif
+
+// glibc lets an executable replace malloc and friends and still reach the
+// originals through their __libc_ names
+#if JUCE_LINUX && defined(__GLIBC__)
+ #include <dlfcn.h>
+ #include <pthread.h>
+ #define VINYL_RT_HOOK_LIBC 1
+
+ extern "C"
+ {
+     void* __libc_malloc(size_t);
+     void* __libc_calloc(size_t, size_t);
+     void* __libc_realloc(void*, size_t);
+     void* __libc_memalign(size_t, size_t);
+     void __libc_free(void*);
+ }
+#else
+ #define VINYL_RT_HOOK_LIBC 0
+#endif
+
+// Thread locals read inside malloc must not allocate on first use
+#if JUCE_GCC || JUCE_CLANG
+ #define VINYL_RT_THREAD_LOCAL thread_local __attribute__((tls_model("initial-exec")))
+#else
+ #define VINYL_RT_THREAD_LOCAL thread_local
+#endif
+
+namespace RealtimeChecks
+{
+    namespace
+    {
+        VINYL_RT_THREAD_LOCAL int audioThreadDepth = 0;
+        VINYL_RT_THREAD_LOCAL int toleratedLockDepth = 0;   // Audio thread depth locks are tolerated at, or 0
+        VINYL_RT_THREAD_LOCAL bool isRecording = false;     // Keeps the recorder from reporting itself
+
+        std::atomic<int> numViolations { 0 };
+        std::array<Violation, maxViolations> violations;
+        std::array<std::atomic<bool>, maxViolations> isWritten {};
+
+        void record(ViolationType type, size_t bytes) noexcept
+        {
+            if (audioThreadDepth == 0 || isRecording)
+                return;
+
+            if (type == ViolationType::lock && audioThreadDepth == toleratedLockDepth)
+                return;
+
+            isRecording = true;
+            const auto index = numViolations.fetch_add(1, std::memory_order_relaxed);
+
+            if (index < maxViolations)
+            {
+                auto& violation = violations[(size_t) index];
+                violation.type = type;
+                violation.bytes = bytes;
+
+               #if VINYL_RT_BACKTRACE
+                violation.numFrames = backtrace(violation.frames, Violation::maxFrames);
+               #endif
+
+                isWritten[(size_t) index].store(true, std::memory_order_release);
+            }
+
+            isRecording = false;
+        }
+
+       #if VINYL_RT_BACKTRACE
+        // backtrace() loads its unwinder on first use, which allocates
+        [[maybe_unused]] const int backtracePrimed = []
+        {
+            void* frames[1];
+            return backtrace(frames, 1);
+        }();
+       #endif
+
+        //==============================================================================
+        void* allocate(size_t size) noexcept
+        {
+            record(ViolationType::allocation, size);
+
+           #if VINYL_RT_HOOK_LIBC
+            return __libc_malloc(size > 0 ? size : 1);
+           #else
+            return std::malloc(size > 0 ? size : 1);
+           #endif
+        }
+
+        void* allocateAligned(size_t size, std::align_val_t alignment) noexcept
+        {
+            record(ViolationType::allocation, size);
+            const auto align = juce::jmax((size_t) alignment, sizeof(void*));
+
+           #if VINYL_RT_HOOK_LIBC
+            return __libc_memalign(align, size > 0 ? size : 1);
+           #elif JUCE_WINDOWS
+            return _aligned_malloc(size > 0 ? size : 1, align);
+           #else
+            void* result = nullptr;
+            return posix_memalign(&result, align, size > 0 ? size : 1) == 0 ? result : nullptr;
+           #endif
+        }
+
+        void release(void* pointer) noexcept
+        {
+            if (pointer == nullptr)
+                return;
+
+            record(ViolationType::deallocation, 0);
+
+           #if VINYL_RT_HOOK_LIBC
+            __libc_free(pointer);
+           #else
+            std::free(pointer);
+           #endif
+        }
+
+        void releaseAligned(void* pointer) noexcept
+        {
+            if (pointer == nullptr)
+                return;
+
+            record(ViolationType::deallocation, 0);
+
+           #if VINYL_RT_HOOK_LIBC
+            __libc_free(pointer);
+           #elif JUCE_WINDOWS
+            _aligned_free(pointer);
+           #else
+            std::free(pointer);
+           #endif
+        }
+
+        template <typename Allocator>
+        void* allocateOrThrow(Allocator&& allocator)
+        {
+            if (auto* pointer = allocator())
+                return pointer;
+
+            throw std::bad_alloc();
+        }
+    }
+
+    //==============================================================================
+    ScopedAudioThread::ScopedAudioThread() noexcept  { ++audioThreadDepth; }
+    ScopedAudioThread::~ScopedAudioThread() noexcept { --audioThreadDepth; }
+
+    ScopedLocksTolerated::ScopedLocksTolerated() noexcept
+        : previousDepth(toleratedLockDepth)
+    {
+        toleratedLockDepth = audioThreadDepth;
+    }
+
+    ScopedLocksTolerated::~ScopedLocksTolerated() noexcept
+    {
+        toleratedLockDepth = previousDepth;
+    }
+
+    int getNumViolations() noexcept
+    {
+        return numViolations.load(std::memory_order_relaxed);
+    }
+
+    bool getViolation(int index, Violation& result) noexcept
+    {
+        if (! juce::isPositiveAndBelow(index, juce::jmin(maxViolations, getNumViolations()))
+            || ! isWritten[(size_t) index].load(std::memory_order_acquire))
+            return false;
+
+        result = violations[(size_t) index];
+        return true;
+    }
+
+    void clearViolations() noexcept
+    {
+        for (auto& written : isWritten)
+            written.store(false, std::memory_order_relaxed);
+
+        numViolations.store(0, std::memory_order_release);
+    }
+
+    juce::String describe(const Violation& violation)
+    {
+        juce::String text;
+
+        switch (violation.type)
+        {
+            case ViolationType::allocation:   text << "allocation of " << (juce::int64) violation.bytes << " bytes"; break;
+            case ViolationType::deallocation: text << "deallocation"; break;
+            case ViolationType::lock:         text << "mutex lock"; break;
+        }
+
+        text << juce::newLine;
+
+       #if VINYL_RT_BACKTRACE
+        if (auto* symbols = backtrace_symbols(violation.frames, violation.numFrames))
+        {
+            // Frame 0 is the recorder itself
+            for (int i = 1; i < violation.numFrames; ++i)
+                text << "    " << symbols[i] << juce::newLine;
+
+            std::free(symbols);
+        }
+       #endif
+
+        return text;
+    }
+}
+
+//==============================================================================
+// Replacements for the global allocation functions. VinylDSP hides its
+// symbols; these are exported, so the C and C++ runtimes' own calls come here too.
+
+#if JUCE_GCC || JUCE_CLANG
+ #pragma GCC visibility push(default)
+#endif
+
+void* operator new(size_t size)                                    { return RealtimeChecks::allocateOrThrow([=] { return RealtimeChecks::allocate(size); }); }
+void* operator new[](size_t size)                                  { return RealtimeChecks::allocateOrThrow([=] { return RealtimeChecks::allocate(size); }); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept    { return RealtimeChecks::allocate(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept  { return RealtimeChecks::allocate(size); }
+
+void* operator new(size_t size, std::align_val_t alignment)        { return RealtimeChecks::allocateOrThrow([=] { return RealtimeChecks::allocateAligned(size, alignment); }); }
+void* operator new[](size_t size, std::align_val_t alignment)      { return RealtimeChecks::allocateOrThrow([=] { return RealtimeChecks::allocateAligned(size, alignment); }); }
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept   { return RealtimeChecks::allocateAligned(size, alignment); }
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return RealtimeChecks::allocateAligned(size, alignment); }
+
+void operator delete(void* pointer) noexcept                                    { RealtimeChecks::release(pointer); }
+void operator delete[](void* pointer) noexcept                                  { RealtimeChecks::release(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept             { RealtimeChecks::release(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept           { RealtimeChecks::release(pointer); }
+void operator delete(void* pointer, size_t) noexcept                            { RealtimeChecks::release(pointer); }
+void operator delete[](void* pointer, size_t) noexcept                          { RealtimeChecks::release(pointer); }
+
+void operator delete(void* pointer, std::align_val_t) noexcept                          { RealtimeChecks::releaseAligned(pointer); }
+void operator delete[](void* pointer, std::align_val_t) noexcept                        { RealtimeChecks::releaseAligned(pointer); }
+void operator delete(void* pointer, std::align_val_t, const std::nothrow_t&) noexcept   { RealtimeChecks::releaseAligned(pointer); }
+void operator delete[](void* pointer, std::align_val_t, const std::nothrow_t&) noexcept { RealtimeChecks::releaseAligned(pointer); }
+void operator delete(void* pointer, size_t, std::align_val_t) noexcept                  { RealtimeChecks::releaseAligned(pointer); }
+void operator delete[](void* pointer, size_t, std::align_val_t) noexcept                { RealtimeChecks::releaseAligned(pointer); }
+
+#if VINYL_RT_HOOK_LIBC
+
+#define VINYL_RT_EXPORT extern "C"
+
+VINYL_RT_EXPORT void* malloc(size_t size) noexcept
+{
+    RealtimeChecks::record(RealtimeChecks::ViolationType::allocation, size);
+    return __libc_malloc(size);
+}
+
+VINYL_RT_EXPORT void* calloc(size_t count, size_t size) noexcept
+{
+    RealtimeChecks::record(RealtimeChecks::ViolationType::allocation, count * size);
+    return __libc_calloc(count, size);
+}
+
+VINYL_RT_EXPORT void* realloc(void* pointer, size_t size) noexcept
+{
+    RealtimeChecks::record(RealtimeChecks::ViolationType::allocation, size);
+    return __libc_realloc(pointer, size);
+}
+
+VINYL_RT_EXPORT void free(void* pointer) noexcept
+{
+    if (pointer != nullptr)
+        RealtimeChecks::record(RealtimeChecks::ViolationType::deallocation, 0);
+
+    __libc_free(pointer);
+}
+
+// The original is looked up on first use. dlsym() takes the loader's own
+// lock, not this one, so the lookup can't come back here.
+VINYL_RT_EXPORT int pthread_mutex_lock(pthread_mutex_t* mutex) noexcept
+{
+    using Lock = int (*)(pthread_mutex_t*);
+    static std::atomic<Lock> original { nullptr };
+
+    auto lock = original.load(std::memory_order_relaxed);
+
+    if (lock == nullptr)
+    {
+        lock = reinterpret_cast<Lock>(dlsym(RTLD_NEXT, "pthread_mutex_lock"));
+        original.store(lock, std::memory_order_relaxed);
+    }
+
+    RealtimeChecks::record(RealtimeChecks::ViolationType::lock, 0);
+    return lock(mutex);
+}
+
+#endif
+
+#if JUCE_GCC || JUCE_CLANG
+ #pragma GCC visibility pop
+#endif
+
+#endif
+
+//==============================================================================
+
+bool RealtimeChecks::writeReport(const juce::File& file, const BlockTimeHistogram& blockTimes)
+{
+    juce::String text;
+    const auto numViolations = getNumViolations();
+
+    text << "Real-time violations: " << numViolations
+         << (enabled ? "" : " (built without VINYL_RT_CHECKS)") << juce::newLine << juce::newLine;
+
+    for (int i = 0; i < juce::jmin(numViolations, maxViolations); ++i)
+    {
+        Violation violation;
+
+        if (getViolation(i, violation))
+            text << describe(violation) << juce::newLine;
+    }
+
+    text << "processBlock time, percent of the block's duration:" << juce::newLine << blockTimes.toString();
+    return file.replaceWithText(text);
+}
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+#ifndef VINYL_RT_CHECKS
+ #define VINYL_RT_CHECKS 0
+#endif
+
+//==============================================================================
+/*
+    Real-time safety checks for the audio thread, compiled in with
+    -DVINYL_RT_CHECKS=ON.
+
+    While a ScopedAudioThread is alive on a thread, every heap allocation or
+    release on it (operator new and delete everywhere; malloc, calloc,
+    realloc and free on Linux) and every blocking mutex lock
+    (pthread_mutex_lock, Linux only) is recorded as a Violation with its call
+    stack. Each record claims a fixed slot with an atomic counter, so
+    recording never allocates or blocks, from any number of audio threads.
+    Stacks are symbolised only when they are described.
+
+    The hooks replace the global allocation functions, so they see everything
+    in the tools and the benchmark, which link VinylDSP statically. Inside a
+    host, the host's own allocator usually wins. processBlock times go into a
+    BlockTimeHistogram in the same builds.
+
+    Without VINYL_RT_CHECKS, ScopedAudioThread is empty and nothing is hooked.
+*/
+namespace RealtimeChecks
+{
+    constexpr bool enabled = VINYL_RT_CHECKS != 0;
+
+    // Marks the calling thread as real-time until destroyed. Nests.
+    class ScopedAudioThread
+    {
+    public:
+       #if VINYL_RT_CHECKS
+        ScopedAudioThread() noexcept;
+        ~ScopedAudioThread() noexcept;
+       #else
+        ScopedAudioThread() noexcept {}
+       #endif
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedAudioThread)
+    };
+
+    // Inside a ScopedAudioThread, stops blocking locks at the current nesting
+    // level from being recorded until destroyed; allocations still are. For
+    // the locks JUCE takes itself when a host delivers a parameter change on
+    // the audio thread. Code that opens its own ScopedAudioThread inside, as
+    // the processor's parameter listener does, is checked in full again.
+    class ScopedLocksTolerated
+    {
+    public:
+       #if VINYL_RT_CHECKS
+        ScopedLocksTolerated() noexcept;
+        ~ScopedLocksTolerated() noexcept;
+       #else
+        ScopedLocksTolerated() noexcept {}
+       #endif
+
+    private:
+       #if VINYL_RT_CHECKS
+        int previousDepth = 0;
+       #endif
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedLocksTolerated)
+    };
+
+    //==============================================================================
+    enum class ViolationType { allocation, deallocation, lock };
+
+    struct Violation
+    {
+        static constexpr int maxFrames = 32;
+
+        ViolationType type = ViolationType::allocation;
+        size_t bytes = 0;   // Allocations only
+        int numFrames = 0;
+        void* frames[maxFrames] {};
+    };
+
+    // Only the first maxViolations are kept, but every one is counted
+    constexpr int maxViolations = 256;
+
+    int getNumViolations() noexcept;
+
+    // False if the slot is past maxViolations or still being written
+    bool getViolation(int index, Violation& result) noexcept;
+
+    // Only while no audio thread is running
+    void clearViolations() noexcept;
+
+    // The type, size and symbolised stack. Allocates; not for the audio thread.
+    juce::String describe(const Violation&);
+
+    //==============================================================================
+    /*
+        processBlock times as a share of the block's duration. Bucket 0 holds
+        blocks under 1/256 of the budget, each bucket after it is twice as
+        wide, and the last holds everything from twice the budget up. The audio
+        thread adds with relaxed atomic increments; readers get a snapshot.
+    */
+    class BlockTimeHistogram
+    {
+    public:
+        static constexpr int numBuckets = 11;
+
+        BlockTimeHistogram() = default;
+
+        void add(double budgetFraction) noexcept
+        {
+            const auto bucket = budgetFraction > 0.0 ? (int) std::floor(std::log2(budgetFraction)) + numBuckets - 2 : 0;
+            counts[(size_t) juce::jlimit(0, numBuckets - 1, bucket)].fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // Budget fraction a bucket ends at; infinity for the last one
+        static double getUpperBound(int bucket) noexcept
+        {
+            return bucket < numBuckets - 1 ? std::exp2(bucket - (numBuckets - 3))
+                                           : std::numeric_limits<double>::infinity();
+        }
+
+        std::array<juce::uint64, numBuckets> getCounts() const noexcept
+        {
+            std::array<juce::uint64, numBuckets> result;
+
+            for (size_t i = 0; i < result.size(); ++i)
+                result[i] = counts[i].load(std::memory_order_relaxed);
+
+            return result;
+        }
+
+        // Upper bound of the bucket holding this share of all blocks, e.g. 0.99
+        double getPercentile(double fraction) const noexcept
+        {
+            const auto snapshot = getCounts();
+            const auto total = std::accumulate(snapshot.begin(), snapshot.end(), juce::uint64());
+            juce::uint64 seen = 0;
+
+            for (int bucket = 0; bucket < numBuckets; ++bucket)
+            {
+                seen += snapshot[(size_t) bucket];
+
+                if (total > 0 && (double) seen >= fraction * (double) total)
+                    return getUpperBound(bucket);
+            }
+
+            return 0.0;
+        }
+
+        // One line per bucket, with its range in percent of the budget and its count
+        juce::String toString() const;
+
+    private:
+        std::array<std::atomic<juce::uint64>, numBuckets> counts {};
+    };
+
+    //==============================================================================
+    // Every recorded violation, then the histogram, as text
+    bool writeReport(const juce::File& file, const BlockTimeHistogram& blockTimes);
+}
@@ -0,0 +1,342 @@
+#include "RenderEngine.h"
+
+//==============================================================================
+struct RenderEngine::Instance
+{
+    std::unique_ptr<VinylAudioProcessor> processor;
+    std::array<float*, VinylAudioProcessor::maxChannels> channels {};
+    juce::AudioBuffer<float> buffer;    // Refers to the arena
+};
+
+//==============================================================================
+class RenderEngine::Worker : public juce::Thread
+{
+public:
+    Worker(RenderEngine& ownerToUse, int workerIndex)
+        : juce::Thread("Vinyl render worker " + juce::String(workerIndex)),
+          owner(ownerToUse), index(workerIndex)
+    {
+    }
+
+    void run() override
+    {
+        if (owner.options.pinThreads && index < 32)
+            setCurrentThreadAffinityMask(1u << index);
+
+        for (;;)
+        {
+            wake.wait(-1);
+
+            if (threadShouldExit())
+                break;
+
+            owner.runJobs(*this);
+        }
+    }
+
+    void stop()
+    {
+        signalThreadShouldExit();
+        wake.signal();
+        stopThread(-1);
+    }
+
+    //==============================================================================
+    // The jobs left in this cycle are jobs[front] to jobs[back - 1], packed
+    // into one word so the owner and thieves can't both take the last one
+    static juce::uint64 pack(juce::uint32 front, juce::uint32 back) noexcept
+    {
+        return (juce::uint64) front | ((juce::uint64) back << 32);
+    }
+
+    void refill() noexcept
+    {
+        queue.store(pack(0, (juce::uint32) jobs.size()), std::memory_order_release);
+    }
+
+    // Owner end
+    int takeFront() noexcept
+    {
+        auto range = queue.load(std::memory_order_relaxed);
+
+        for (;;)
+        {
+            const auto front = (juce::uint32) range, back = (juce::uint32) (range >> 32);
+
+            if (front >= back)
+                return -1;
+
+            if (queue.compare_exchange_weak(range, pack(front + 1, back), std::memory_order_acquire, std::memory_order_relaxed))
+                return jobs[front];
+        }
+    }
+
+    // Thief end
+    int stealBack() noexcept
+    {
+        auto range = queue.load(std::memory_order_relaxed);
+
+        for (;;)
+        {
+            const auto front = (juce::uint32) range, back = (juce::uint32) (range >> 32);
+
+            if (front >= back)
+                return -1;
+
+            if (queue.compare_exchange_weak(range, pack(front, back - 1), std::memory_order_acquire, std::memory_order_relaxed))
+                return jobs[back - 1];
+        }
+    }
+
+    //==============================================================================
+    RenderEngine& owner;
+    const int index;
+    std::vector<int> jobs;      // The instances this worker owns
+    juce::WaitableEvent wake;
+
+    // Touched by other workers when they steal, so kept off the lines below
+    alignas(64) std::atomic<juce::uint64> queue { 0 };
+
+    // Only written by this worker
+    struct alignas(64) Counters
+    {
+        juce::int64 numJobs = 0, numStolenJobs = 0;
+        juce::int64 latencyTicks = 0, worstLatencyTicks = 0;
+        juce::int64 processTicks = 0;
+    };
+
+    Counters counters;
+
+    JUCE_DECLARE_NON_COPYABLE(Worker)
+};
+
+//==============================================================================
+RenderEngine::RenderEngine()
+    : RenderEngine(Options())
+{
+}
+
+RenderEngine::RenderEngine(const Options& optionsToUse)
+    : options(optionsToUse)
+{
+    const auto numThreads = options.numThreads > 0 ? options.numThreads : juce::SystemStats::getNumCpus();
+
+    for (int i = 0; i < numThreads; ++i)
+        workers.push_back(std::make_unique<Worker>(*this, i));
+}
+
+RenderEngine::~RenderEngine()
+{
+    release();
+}
+
+int RenderEngine::addInstance(std::unique_ptr<VinylAudioProcessor> processor)
+{
+    jassert(arena == nullptr);
+
+    auto instance = std::make_unique<Instance>();
+    instance->processor = std::move(processor);
+    instances.push_back(std::move(instance));
+    return (int) instances.size() - 1;
+}
+
+VinylAudioProcessor& RenderEngine::getProcessor(int index) noexcept
+{
+    return *instances[(size_t) index]->processor;
+}
+
+juce::AudioBuffer<float>& RenderEngine::getBuffer(int index) noexcept
+{
+    return instances[(size_t) index]->buffer;
+}
+
+//==============================================================================
+bool RenderEngine::prepare(double newSampleRate, int numChannels, int blockSize, int bufferLength)
+{
+    release();
+
+    jassert(numChannels > 0 && numChannels <= VinylAudioProcessor::maxChannels);
+    sampleRate = newSampleRate;
+
+    const auto channelSet = juce::AudioChannelSet::canonicalChannelSet(numChannels);
+
+    juce::AudioProcessor::BusesLayout layout;
+    layout.inputBuses.add(channelSet);
+    layout.outputBuses.add(channelSet);
+
+    for (auto& instance : instances)
+        if (channelSet.isDisabled() || ! instance->processor->setBusesLayout(layout))
+            return false;
+
+    for (auto& instance : instances)
+    {
+        instance->processor->setRateAndBufferSizeDetails(sampleRate, blockSize);
+        instance->processor->prepareToPlay(sampleRate, blockSize);
+    }
+
+    // Padded channels are whole cache lines, starting on a line boundary
+    constexpr int floatsPerLine = 64 / (int) sizeof(float);
+    const auto stride = options.layout == Layout::padded ? (bufferLength + floatsPerLine - 1) / floatsPerLine * floatsPerLine
+                                                         : bufferLength;
+
+    arena.calloc((size_t) stride * (size_t) numChannels * instances.size() + (size_t) floatsPerLine);
+
+    auto* data = reinterpret_cast<float*>((reinterpret_cast<std::uintptr_t>(arena.get()) + 63) & ~(std::uintptr_t) 63);
+
+    for (auto& instance : instances)
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            instance->channels[(size_t) channel] = data;
+            data += stride;
+        }
+
+        instance->buffer.setDataToReferTo(instance->channels.data(), numChannels, bufferLength);
+    }
+
+    // Instance n belongs to worker n modulo the number of workers
+    for (auto& worker : workers)
+    {
+        worker->jobs.clear();
+        worker->queue.store(0, std::memory_order_relaxed);
+    }
+
+    for (int i = 0; i < (int) instances.size(); ++i)
+        workers[(size_t) i % workers.size()]->jobs.push_back(i);
+
+    for (auto& worker : workers)
+        worker->startThread();
+
+    resetStats();
+    return true;
+}
+
+void RenderEngine::release()
+{
+    for (auto& worker : workers)
+        worker->stop();
+
+    if (arena != nullptr)
+    {
+        for (auto& instance : instances)
+        {
+            instance->buffer = {};
+            instance->processor->releaseResources();
+        }
+
+        arena.free();
+    }
+}
+
+//==============================================================================
+void RenderEngine::process(int startSample, int numSamples)
+{
+    jassert(arena != nullptr);
+
+    if (instances.empty() || numSamples <= 0)
+        return;
+
+    const auto start = juce::Time::getHighResolutionTicks();
+
+    cycleStart = startSample;
+    cycleLength = numSamples;
+    cycleStartTicks.store(start, std::memory_order_relaxed);
+    pendingJobs.store((int) instances.size(), std::memory_order_relaxed);
+
+    for (auto& worker : workers)
+        worker->refill();
+
+    for (auto& worker : workers)
+        worker->wake.signal();
+
+    cycleDone.wait(-1);
+
+    const auto elapsed = juce::Time::getHighResolutionTicks() - start;
+    ++numCycles;
+    wallTicks += elapsed;
+    worstCycleTicks = juce::jmax(worstCycleTicks, elapsed);
+    samplesProcessed += (juce::int64) numSamples * (juce::int64) instances.size();
+}
+
+void RenderEngine::runJobs(Worker& worker) noexcept
+{
+    auto job = worker.takeFront();
+
+    while (job >= 0)
+    {
+        runJob(worker, job, false);
+        job = worker.takeFront();
+    }
+
+    // Out of work: steal, starting with the next worker along
+    const auto numWorkers = workers.size();
+
+    for (size_t i = 1; i < numWorkers; ++i)
+    {
+        auto& victim = *workers[((size_t) worker.index + i) % numWorkers];
+        job = victim.stealBack();
+
+        while (job >= 0)
+        {
+            runJob(worker, job, true);
+            job = victim.stealBack();
+        }
+    }
+}
+
+void RenderEngine::runJob(Worker& worker, int index, bool stolen) noexcept
+{
+    auto& instance = *instances[(size_t) index];
+    const auto start = juce::Time::getHighResolutionTicks();
+
+    juce::AudioBuffer<float> block(instance.channels.data(), instance.buffer.getNumChannels(), cycleStart, cycleLength);
+    juce::MidiBuffer midi;
+    instance.processor->processBlock(block, midi);
+
+    const auto end = juce::Time::getHighResolutionTicks();
+    const auto latency = end - cycleStartTicks.load(std::memory_order_relaxed);
+
+    auto& counters = worker.counters;
+    ++counters.numJobs;
+    counters.numStolenJobs += stolen ? 1 : 0;
+    counters.latencyTicks += latency;
+    counters.worstLatencyTicks = juce::jmax(counters.worstLatencyTicks, latency);
+    counters.processTicks += end - start;
+
+    if (pendingJobs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        cycleDone.signal();
+}
+
+//==============================================================================
+RenderEngine::Stats RenderEngine::getStats() const noexcept
+{
+    Stats stats;
+    juce::int64 latencyTicks = 0, worstLatencyTicks = 0, processTicks = 0;
+
+    for (auto& worker : workers)
+    {
+        const auto& counters = worker->counters;
+        stats.numJobs += counters.numJobs;
+        stats.numStolenJobs += counters.numStolenJobs;
+        latencyTicks += counters.latencyTicks;
+        worstLatencyTicks = juce::jmax(worstLatencyTicks, counters.worstLatencyTicks);
+        processTicks += counters.processTicks;
+    }
+
+    stats.numCycles = numCycles;
+    stats.meanJobLatencySeconds = juce::Time::highResolutionTicksToSeconds(latencyTicks) / (double) juce::jmax((juce::int64) 1, stats.numJobs);
+    stats.worstJobLatencySeconds = juce::Time::highResolutionTicksToSeconds(worstLatencyTicks);
+    stats.worstCycleSeconds = juce::Time::highResolutionTicksToSeconds(worstCycleTicks);
+    stats.processSeconds = juce::Time::highResolutionTicksToSeconds(processTicks);
+    stats.wallSeconds = juce::Time::highResolutionTicksToSeconds(wallTicks);
+    stats.audioSeconds = (double) samplesProcessed / sampleRate;
+    return stats;
+}
+
+void RenderEngine::resetStats() noexcept
+{
+    for (auto& worker : workers)
+        worker->counters = {};
+
+    numCycles = wallTicks = worstCycleTicks = samplesProcessed = 0;
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+//==============================================================================
+/*
+    Runs many VinylAudioProcessor instances side by side, one per stem, for
+    rendering on a server.
+
+    Every process() call is a cycle: one job per instance, each processing
+    the same range of that instance's buffer. Worker threads own a fixed
+    share of the instances, so an instance keeps running on the same core
+    and finds its state in that core's cache. A worker that runs out of its
+    own jobs steals from the back of the others' queues. The queues are a
+    single atomic word each, so neither taking nor stealing a job locks.
+
+    With pinning on, worker n only runs on CPU n. Only the first 32 CPUs can
+    be pinned to; workers above that float.
+
+    The instances' audio lives in one arena allocated in prepare(). In the
+    padded layout every channel starts on its own cache line, so no two
+    instances ever write to the same line; the packed layout leaves the
+    channels back to back, to measure what sharing lines costs.
+
+    Each job's latency is measured from the start of its cycle to the end of
+    the job; getStats() reports it with the throughput.
+*/
+class RenderEngine
+{
+public:
+    enum class Layout { padded, packed };
+
+    struct Options
+    {
+        int numThreads = 0;         // 0 uses every CPU
+        bool pinThreads = true;
+        Layout layout = Layout::padded;
+    };
+
+    struct Stats
+    {
+        juce::int64 numCycles = 0;
+        juce::int64 numJobs = 0;
+        juce::int64 numStolenJobs = 0;      // Run by a worker other than their owner
+        double meanJobLatencySeconds = 0.0;
+        double worstJobLatencySeconds = 0.0;
+        double worstCycleSeconds = 0.0;
+        double processSeconds = 0.0;        // Summed over every job
+        double wallSeconds = 0.0;           // Summed over every cycle
+        double audioSeconds = 0.0;          // Summed over every instance
+
+        // Seconds of audio rendered per second of wall time, over all instances
+        double getRealtimeFactor() const noexcept   { return audioSeconds / juce::jmax(1.0e-9, wallSeconds); }
+    };
+
+    RenderEngine();
+    explicit RenderEngine(const Options& options);
+    ~RenderEngine();
+
+    //==============================================================================
+    // Adds an instance, with its parameters already set. Not while prepared.
+    int addInstance(std::unique_ptr<VinylAudioProcessor> processor);
+
+    int getNumInstances() const noexcept                { return (int) instances.size(); }
+    int getNumThreads() const noexcept                  { return (int) workers.size(); }
+    VinylAudioProcessor& getProcessor(int index) noexcept;
+
+    // Prepares every instance for numChannels in and out and allocates the
+    // arena, with bufferLength samples per channel and instance. Starts the
+    // workers. Returns false if an instance doesn't accept the channel count.
+    bool prepare(double sampleRate, int numChannels, int blockSize, int bufferLength);
+
+    // Stops the workers, releases the instances and frees the arena
+    void release();
+
+    // An instance's part of the arena. Write its input here before process()
+    // and read its output back afterwards.
+    juce::AudioBuffer<float>& getBuffer(int index) noexcept;
+
+    //==============================================================================
+    // Processes samples startSample to startSample + numSamples of every
+    // instance's buffer and returns when all of them are done. Not reentrant.
+    void process(int startSample, int numSamples);
+
+    Stats getStats() const noexcept;
+    void resetStats() noexcept;
+
+private:
+    //==============================================================================
+    struct Instance;
+    class Worker;
+
+    void runJobs(Worker& worker) noexcept;
+    void runJob(Worker& worker, int index, bool stolen) noexcept;
+
+    Options options;
+    std::vector<std::unique_ptr<Instance>> instances;
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    juce::HeapBlock<float> arena;
+
+    // The current cycle
+    int cycleStart = 0, cycleLength = 0;
+    std::atomic<juce::int64> cycleStartTicks { 0 };
+    std::atomic<int> pendingJobs { 0 };
+    juce::WaitableEvent cycleDone;
+
+    juce::int64 numCycles = 0, wallTicks = 0, worstCycleTicks = 0;
+    juce::int64 samplesProcessed = 0;
+    double sampleRate = 44100.0;
+
+    JUCE_DECLARE_NON_COPYABLE(RenderEngine)
+};
@@ -0,0 +1,198 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+    Tape-style soft saturation, optionally oversampled 2x or 4x.
+
+    The shaper is the cubic f(x) = x - 4/27 x^3, clipped at |x| = 1.5 where it
+    reaches +-1 with zero slope. It is applied with FloatVectorOperations and a
+    branch-free polynomial loop instead of a per-sample std::tanh.
+
+    All four oversamplers (2x/4x, minimum latency IIR or linear phase FIR) are
+    built in prepare(), so switching between them never allocates. An amount
+    of 0 bypasses the stage completely, oversampling included.
+
+    Drive changes ramp sample by sample over 20 ms. When oversampling, each
+    base rate sample's drive is held across its oversampled samples.
+*/
+template <typename SampleType>
+class SaturationStage
+{
+public:
+    enum class Factor { none = 0, twoTimes, fourTimes };
+    enum class FilterMode { minimumLatency = 0, linearPhase };
+
+    SaturationStage() = default;
+
+    //==============================================================================
+    void prepare(const juce::dsp::ProcessSpec& spec)
+    {
+        using Oversampling = juce::dsp::Oversampling<SampleType>;
+
+        for (int stages = 1; stages <= 2; ++stages)
+        {
+            for (auto mode : { FilterMode::minimumLatency, FilterMode::linearPhase })
+            {
+                const auto type = mode == FilterMode::linearPhase ? Oversampling::filterHalfBandFIREquiripple
+                                                                  : Oversampling::filterHalfBandPolyphaseIIR;
+
+                auto& oversampler = oversamplers[(size_t) getIndex((Factor) stages, mode)];
+                oversampler = std::make_unique<Oversampling>(spec.numChannels, (size_t) stages, type, true, false);
+                oversampler->initProcessing(spec.maximumBlockSize);
+            }
+        }
+
+        drive.reset(spec.sampleRate, 0.02);
+        driveRamp.assign((size_t) spec.maximumBlockSize, SampleType(1));
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        for (auto& oversampler : oversamplers)
+            if (oversampler != nullptr)
+                oversampler->reset();
+
+        activeOversampler = nullptr;
+    }
+
+    //==============================================================================
+    // 0 bypasses the stage, 1 is the most drive
+    void setAmount(SampleType newAmount) noexcept
+    {
+        amount = juce::jlimit(SampleType(0), SampleType(1), newAmount);
+        drive.setTargetValue(SampleType(1) + SampleType(7) * amount);
+    }
+
+    void setOversampling(Factor newFactor, FilterMode newMode) noexcept
+    {
+        factor = newFactor;
+        mode = newMode;
+    }
+
+    bool isBypassed() const noexcept { return amount <= SampleType(0); }
+
+    // Latency the given setting would add, in samples at the base rate
+    float getLatencyInSamples(Factor latencyFactor, FilterMode latencyMode) const noexcept
+    {
+        if (latencyFactor == Factor::none)
+            return 0.0f;
+
+        auto& oversampler = oversamplers[(size_t) getIndex(latencyFactor, latencyMode)];
+        return oversampler != nullptr ? (float) oversampler->getLatencyInSamples() : 0.0f;
+    }
+
+    //==============================================================================
+    void process(const juce::dsp::ProcessContextReplacing<SampleType>& context) noexcept
+    {
+        if (isBypassed())
+        {
+            activeOversampler = nullptr;
+            drive.setCurrentAndTargetValue(drive.getTargetValue());
+            return;
+        }
+
+        auto& block = context.getOutputBlock();
+        const auto numSamples = block.getNumSamples();
+        jassert(numSamples <= driveRamp.size());
+
+        // Only a moving drive pays for the per-sample ramp
+        const auto isRamping = drive.isSmoothing();
+
+        if (isRamping)
+            for (size_t i = 0; i < numSamples; ++i)
+                driveRamp[i] = drive.getNextValue();
+
+        if (factor == Factor::none)
+        {
+            activeOversampler = nullptr;
+
+            if (isRamping)
+                shape(block, driveRamp.data(), 1);
+            else
+                shape(block, drive.getCurrentValue());
+
+            return;
+        }
+
+        auto* oversampler = oversamplers[(size_t) getIndex(factor, mode)].get();
+
+        // Start a newly selected oversampler from silence rather than stale state
+        if (oversampler != activeOversampler)
+        {
+            oversampler->reset();
+            activeOversampler = oversampler;
+        }
+
+        auto upsampled = oversampler->processSamplesUp(block);
+
+        if (isRamping)
+            shape(upsampled, driveRamp.data(), (int) (upsampled.getNumSamples() / numSamples));
+        else
+            shape(upsampled, drive.getCurrentValue());
+
+        oversampler->processSamplesDown(block);
+    }
+
+private:
+    //==============================================================================
+    static int getIndex(Factor factorToUse, FilterMode modeToUse) noexcept
+    {
+        return ((int) factorToUse - 1) * 2 + (int) modeToUse;
+    }
+
+    static void shape(const juce::dsp::AudioBlock<SampleType>& block, SampleType driveValue) noexcept
+    {
+        // Unity gain for small signals would make the knob a pure loudness
+        // control at high drive; meet halfway instead
+        const auto makeUp = SampleType(1) / std::sqrt(driveValue);
+        const auto numSamples = (int) block.getNumSamples();
+
+        for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+        {
+            auto* data = block.getChannelPointer(channel);
+
+            juce::FloatVectorOperations::multiply(data, driveValue, numSamples);
+            juce::FloatVectorOperations::clip(data, data, SampleType(-1.5), SampleType(1.5), numSamples);
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                const auto x = data[i];
+                data[i] = makeUp * x * (SampleType(1) - SampleType(4.0 / 27.0) * x * x);
+            }
+        }
+    }
+
+    // The same shaper with the drive changing every samplesPerDrive samples
+    static void shape(const juce::dsp::AudioBlock<SampleType>& block, const SampleType* drives, int samplesPerDrive) noexcept
+    {
+        const auto numSamples = (int) block.getNumSamples();
+
+        for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+        {
+            auto* data = block.getChannelPointer(channel);
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                const auto driveValue = drives[i / samplesPerDrive];
+                const auto x = juce::jlimit(SampleType(-1.5), SampleType(1.5), data[i] * driveValue);
+                data[i] = x * (SampleType(1) - SampleType(4.0 / 27.0) * x * x) / std::sqrt(driveValue);
+            }
+        }
+    }
+
+    //==============================================================================
+    std::array<std::unique_ptr<juce::dsp::Oversampling<SampleType>>, 4> oversamplers;
+    juce::dsp::Oversampling<SampleType>* activeOversampler = nullptr;
+
+    SampleType amount = 0;
+    juce::SmoothedValue<SampleType, juce::ValueSmoothingTypes::Multiplicative> drive { SampleType(1) };
+    std::vector<SampleType> driveRamp;      // One drive per base rate sample, while ramping
+
+    Factor factor = Factor::twoTimes;
+    FilterMode mode = FilterMode::minimumLatency;
+
+    JUCE_DECLARE_NON_COPYABLE(SaturationStage)
+};
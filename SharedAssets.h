@@ -0,0 +1,249 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+    An immutable block of data built once and shared by every instance in
+    the process: a crackle bank, a wavetable, a table of filter coefficients.
+
+    The data either lives in memory owned by the asset or in a memory mapped
+    cache file, and is read through getData().
+*/
+class SharedAsset
+{
+public:
+    template <typename Element>
+    const Element* getData() const noexcept             { return static_cast<const Element*>(data); }
+
+    template <typename Element>
+    size_t getNumElements() const noexcept              { return numBytes / sizeof(Element); }
+
+    size_t getSizeInBytes() const noexcept              { return numBytes; }
+    bool isMemoryMapped() const noexcept                { return mappedFile != nullptr; }
+
+private:
+    friend class SharedAssets;
+
+    SharedAsset() = default;
+
+    juce::HeapBlock<char> storage;
+    std::unique_ptr<juce::MemoryMappedFile> mappedFile;
+    const void* data = nullptr;
+    size_t numBytes = 0;
+
+    JUCE_DECLARE_NON_COPYABLE(SharedAsset)
+};
+
+//==============================================================================
+/*
+    Process-wide cache of SharedAssets, keyed by name, sample rate and quality
+    setting.
+
+    get() builds an asset the first time it is asked for, under a lock, and
+    hands out shared_ptrs; the asset is freed when the last instance lets go.
+    Stages fetch their assets in prepare() and keep the pointer, so the audio
+    thread only ever reads immutable memory and never touches the cache.
+
+    When the cache directory exists, every asset is written there the first
+    time it is built, and later runs map the file instead of building it
+    again. Mapped pages are shared with every other process using the same
+    directory. The default is Vinyl/AssetCache in the user's application data
+    folder, which nothing creates: an installer or the user opts in by making
+    it. Bump formatVersion whenever a builder's output changes, so stale files
+    are rebuilt rather than read.
+
+    Callers say how many elements the asset holds. A live asset or a cache
+    file of any other size is never handed out; it is built again instead.
+    Keys round the sample rate to whole Hz, so a builder that depends on the
+    rate must build for the rounded one, or instances at nearby rates would
+    share an asset laid out for somebody else.
+*/
+class SharedAssets
+{
+public:
+    struct Key
+    {
+        juce::String name;
+        double sampleRate = 0.0;    // 0 for assets that don't depend on it
+        int quality = 0;
+    };
+
+    // The rate an asset for this sample rate is keyed, and must be built, at
+    static double getKeyRate(double sampleRate) noexcept    { return (double) juce::roundToInt(sampleRate); }
+
+    static constexpr juce::uint32 formatVersion = 1;
+
+    // The asset for this key, numElements long, built by
+    // build(std::vector<Element>&) if nobody holds one. Not for the audio thread.
+    template <typename Element, typename Builder>
+    static std::shared_ptr<const SharedAsset> get(const Key& key, size_t numElements, Builder&& build)
+    {
+        static_assert(std::is_trivially_copyable_v<Element>, "Assets are copied and mapped as raw bytes");
+
+        auto& cache = getCache();
+        const juce::ScopedLock scopedLock(cache.lock);
+
+        removeExpired(cache);
+
+        const auto fileName = getFileName(key, sizeof(Element));
+        const auto numBytes = numElements * sizeof(Element);
+        auto& entry = cache.assets[fileName];
+
+        // One of another size stays with whoever holds it, and this key
+        // moves on to a new one
+        if (auto existing = entry.lock())
+            if (existing->getSizeInBytes() == numBytes)
+                return existing;
+
+        std::shared_ptr<SharedAsset> asset(new SharedAsset());
+
+        if (! mapFile(*asset, cache.directory, fileName, sizeof(Element), numBytes))
+        {
+            std::vector<Element> elements;
+            build(elements);
+            jassert(elements.size() == numElements);
+
+            asset->numBytes = elements.size() * sizeof(Element);
+            asset->storage.malloc(juce::jmax((size_t) 1, asset->numBytes));
+            std::memcpy(asset->storage.get(), elements.data(), asset->numBytes);
+            asset->data = asset->storage.get();
+
+            writeFile(*asset, cache.directory, fileName, sizeof(Element));
+        }
+
+        entry = asset;
+        return asset;
+    }
+
+    // Where assets are cached on disk. A directory that doesn't exist turns the
+    // disk cache off; assets already built stay as they are.
+    static void setCacheDirectory(const juce::File& directory)
+    {
+        auto& cache = getCache();
+        const juce::ScopedLock scopedLock(cache.lock);
+        cache.directory = directory;
+    }
+
+    // Bytes held by every live asset, and how much of that is mapped from disk
+    static size_t getTotalBytes(bool mappedOnly = false)
+    {
+        auto& cache = getCache();
+        const juce::ScopedLock scopedLock(cache.lock);
+
+        size_t total = 0;
+
+        for (auto& [name, entry] : cache.assets)
+            if (auto asset = entry.lock())
+                if (! mappedOnly || asset->isMemoryMapped())
+                    total += asset->getSizeInBytes();
+
+        return total;
+    }
+
+private:
+    //==============================================================================
+    struct Cache
+    {
+        juce::CriticalSection lock;
+        juce::File directory { juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+                                   .getChildFile("Vinyl").getChildFile("AssetCache") };
+        std::map<juce::String, std::weak_ptr<const SharedAsset>> assets;
+    };
+
+    static Cache& getCache()
+    {
+        static Cache cache;
+        return cache;
+    }
+
+    // Entries whose asset every instance has let go of. Called under the lock.
+    static void removeExpired(Cache& cache)
+    {
+        for (auto it = cache.assets.begin(); it != cache.assets.end();)
+        {
+            if (it->second.expired())
+                it = cache.assets.erase(it);
+            else
+                ++it;
+        }
+    }
+
+    // Cache files start with a header, padded so the data stays aligned
+    struct FileHeader
+    {
+        juce::uint32 magic = 0x54534e56;    // "VNST"
+        juce::uint32 version = formatVersion;
+        juce::uint64 elementSize = 0;
+        juce::uint64 numBytes = 0;
+        char padding[40] {};
+    };
+
+    static_assert(sizeof(FileHeader) == 64, "Cache file header must keep the data 64-byte aligned");
+
+    static juce::String getFileName(const Key& key, size_t elementSize)
+    {
+        return key.name + "-" + juce::String(juce::roundToInt(key.sampleRate)) + "-q" + juce::String(key.quality)
+             + "-" + juce::String((int) elementSize) + ".bin";
+    }
+
+    // Only a file holding exactly numBytes of data is mapped; anything else
+    // is rebuilt and overwritten
+    static bool mapFile(SharedAsset& asset, const juce::File& directory, const juce::String& fileName,
+                        size_t elementSize, size_t numBytes)
+    {
+        if (! directory.isDirectory())
+            return false;
+
+        const auto file = directory.getChildFile(fileName);
+
+        if (! file.existsAsFile())
+            return false;
+
+        auto mapped = std::make_unique<juce::MemoryMappedFile>(file, juce::MemoryMappedFile::readOnly);
+
+        if (mapped->getData() == nullptr || mapped->getSize() < sizeof(FileHeader))
+            return false;
+
+        FileHeader header;
+        std::memcpy(&header, mapped->getData(), sizeof(header));
+
+        const FileHeader expected;
+
+        if (header.magic != expected.magic || header.version != expected.version
+             || header.elementSize != elementSize || header.numBytes != numBytes
+             || header.numBytes + sizeof(FileHeader) != mapped->getSize())
+            return false;
+
+        asset.data = static_cast<const char*>(mapped->getData()) + sizeof(FileHeader);
+        asset.numBytes = (size_t) header.numBytes;
+        asset.mappedFile = std::move(mapped);
+        return true;
+    }
+
+    // Written to a temporary file and moved into place, so another process
+    // never maps a half-written asset
+    static void writeFile(const SharedAsset& asset, const juce::File& directory, const juce::String& fileName, size_t elementSize)
+    {
+        if (! directory.isDirectory())
+            return;
+
+        juce::TemporaryFile temporary(directory.getChildFile(fileName));
+
+        {
+            juce::FileOutputStream stream(temporary.getFile());
+
+            if (! stream.openedOk())
+                return;
+
+            FileHeader header;
+            header.elementSize = elementSize;
+            header.numBytes = asset.numBytes;
+
+            if (! stream.write(&header, sizeof(header)) || ! stream.write(asset.data, asset.numBytes))
+                return;
+        }
+
+        temporary.overwriteTargetFileWithTemporary();
+    }
+};
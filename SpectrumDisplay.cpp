@@ -0,0 +1,179 @@
+#include "SpectrumDisplay.h"
+
+//==============================================================================
+
+SpectrumDisplay::SpectrumDisplay()
+    : history((size_t) fftSize, 0.0f),
+      fftData((size_t) fftSize * 2, 0.0f),
+      spectrum((size_t) numBins, minDecibels)
+{
+    setOpaque(true);
+}
+
+//==============================================================================
+
+void SpectrumDisplay::pushSamples(const float* samples, int numSamples, double sampleRate)
+{
+    spectrumRate = sampleRate;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        history[(size_t) historyPosition] = samples[i];
+        historyPosition = (historyPosition + 1) % fftSize;
+    }
+
+    hasNewSamples = hasNewSamples || numSamples > 0;
+}
+
+void SpectrumDisplay::update()
+{
+    if (! hasNewSamples)
+        return;
+
+    hasNewSamples = false;
+
+    // Oldest sample first
+    std::copy(history.begin() + historyPosition, history.end(), fftData.begin());
+    std::copy(history.begin(), history.begin() + historyPosition, fftData.begin() + (fftSize - historyPosition));
+    std::fill(fftData.begin() + fftSize, fftData.end(), 0.0f);
+
+    window.multiplyWithWindowingTable(fftData.data(), (size_t) fftSize);
+    fft.performFrequencyOnlyForwardTransform(fftData.data());
+
+    // A full scale sine through the Hann window peaks at fftSize / 4
+    const auto scale = 4.0f / (float) fftSize;
+
+    for (int bin = 0; bin < numBins; ++bin)
+    {
+        const auto decibels = juce::Decibels::gainToDecibels(fftData[(size_t) bin] * scale, minDecibels);
+        auto& shown = spectrum[(size_t) bin];
+        shown = juce::jmax(decibels, shown - releaseDecibels);
+    }
+
+    rebuildSpectrumPath();
+    repaint();
+}
+
+void SpectrumDisplay::setEQResponse(const BiquadCoefficients<double>* sections, int numSections, double sampleRate)
+{
+    eqSections.assign(sections, sections + numSections);
+    eqRate = sampleRate;
+
+    rebuildEQPath();
+    repaint();
+}
+
+//==============================================================================
+
+void SpectrumDisplay::paint(juce::Graphics& g)
+{
+    g.drawImage(background, getLocalBounds().toFloat());
+
+    g.setColour(juce::Colours::lightgrey.withAlpha(0.25f));
+    g.fillPath(spectrumPath);
+    g.setColour(juce::Colours::lightgrey);
+    g.strokePath(spectrumPath, juce::PathStrokeType(1.0f));
+
+    g.setColour(juce::Colours::green);
+    g.strokePath(eqPath, juce::PathStrokeType(2.0f));
+}
+
+void SpectrumDisplay::resized()
+{
+    renderBackground();
+    rebuildSpectrumPath();
+    rebuildEQPath();
+}
+
+//==============================================================================
+
+float SpectrumDisplay::getX(double frequency) const noexcept
+{
+    return (float) (getWidth() * std::log(frequency / minFrequency) / std::log(maxFrequency / minFrequency));
+}
+
+double SpectrumDisplay::getFrequency(float x) const noexcept
+{
+    return minFrequency * std::pow(maxFrequency / minFrequency, (double) x / juce::jmax(1, getWidth()));
+}
+
+void SpectrumDisplay::renderBackground()
+{
+    const auto width = (float) getWidth();
+    const auto height = (float) getHeight();
+    const auto scale = juce::Component::getApproximateScaleFactorForComponent(this);
+
+    background = juce::Image(juce::Image::RGB,
+                             juce::jmax(1, juce::roundToInt(width * scale)),
+                             juce::jmax(1, juce::roundToInt(height * scale)),
+                             false);
+
+    juce::Path gridPath;
+
+    for (auto frequency : { 100.0, 1000.0, 10000.0 })
+    {
+        const auto x = getX(frequency);
+        gridPath.addLineSegment({ x, 0.0f, x, height }, 1.0f);
+    }
+
+    // Every 24 dB of the spectrum and every 12 dB of the EQ curve, whose 0 dB
+    // is the middle line
+    for (int i = 1; i < 4; ++i)
+    {
+        const auto y = height * (float) i / 4.0f;
+        gridPath.addLineSegment({ 0.0f, y, width, y }, 1.0f);
+    }
+
+    juce::Graphics g(background);
+    g.addTransform(juce::AffineTransform::scale(scale));
+
+    g.fillAll(juce::Colours::black);
+    g.setColour(juce::Colours::darkgrey);
+    g.strokePath(gridPath, juce::PathStrokeType(1.0f));
+}
+
+void SpectrumDisplay::rebuildSpectrumPath()
+{
+    const auto width = (float) getWidth();
+    const auto height = (float) getHeight();
+
+    spectrumPath.clear();
+    spectrumPath.startNewSubPath(0.0f, height);
+
+    for (auto x = 0.0f; x <= width; x += 2.0f)
+    {
+        const auto bin = (float) (getFrequency(x) * fftSize / spectrumRate);
+
+        if (bin >= (float) (numBins - 1))
+            break;
+
+        const auto index = (int) bin;
+        const auto decibels = juce::jmap(bin - (float) index, spectrum[(size_t) index], spectrum[(size_t) index + 1]);
+        spectrumPath.lineTo(x, juce::jmap(decibels, minDecibels, 0.0f, height, 0.0f));
+    }
+
+    spectrumPath.lineTo(spectrumPath.getCurrentPosition().x, height);
+    spectrumPath.closeSubPath();
+}
+
+void SpectrumDisplay::rebuildEQPath()
+{
+    const auto width = (float) getWidth();
+    const auto height = (float) getHeight();
+
+    eqPath.clear();
+
+    for (auto x = 0.0f; x <= width; x += 2.0f)
+    {
+        const auto frequency = juce::jmin(getFrequency(x), eqRate * 0.5);
+        const auto magnitude = BiquadDesign::getMagnitude(eqSections.data(), (int) eqSections.size(), frequency, eqRate);
+        const auto decibels = juce::jlimit(-eqRangeDecibels, eqRangeDecibels,
+                                           (float) juce::Decibels::gainToDecibels(magnitude, -100.0));
+        const auto y = juce::jmap(decibels, -eqRangeDecibels, eqRangeDecibels, height, 0.0f);
+
+        if (x == 0.0f)
+            eqPath.startNewSubPath(x, y);
+        else
+            eqPath.lineTo(x, y);
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "BiquadDesign.h"
+
+//==============================================================================
+/*
+    Output spectrum with the EQ's response curve drawn over it.
+
+    The editor feeds it the samples it drains from the AnalysisFeed and calls
+    update() on its timer. The background and grid are rendered to an image
+    on resize; the spectrum and the EQ curve are kept as paths, the spectrum
+    rebuilt only when new samples came in and the EQ curve only when the EQ
+    settings change. Only this component repaints, never the whole editor.
+*/
+class SpectrumDisplay : public juce::Component
+{
+public:
+    SpectrumDisplay();
+
+    //==============================================================================
+    // Adds samples at the given rate to the analysis window
+    void pushSamples(const float* samples, int numSamples, double sampleRate);
+
+    // Analyses the latest window and repaints, if samples came in since the last call
+    void update();
+
+    // Replaces the EQ curve with the response of these sections in series
+    void setEQResponse(const BiquadCoefficients<double>* sections, int numSections, double sampleRate);
+
+    //==============================================================================
+    void paint(juce::Graphics&) override;
+    void resized() override;
+
+private:
+    //==============================================================================
+    static constexpr int fftOrder = 11;
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr int numBins = fftSize / 2 + 1;
+
+    static constexpr double minFrequency = 20.0, maxFrequency = 20000.0;
+    static constexpr float minDecibels = -96.0f;
+    static constexpr float releaseDecibels = 1.5f;      // Per update, about 45 dB/s at 30 Hz
+    static constexpr float eqRangeDecibels = 24.0f;     // Above and below the centre line
+
+    float getX(double frequency) const noexcept;
+    double getFrequency(float x) const noexcept;
+
+    void renderBackground();
+    void rebuildSpectrumPath();
+    void rebuildEQPath();
+
+    //==============================================================================
+    juce::dsp::FFT fft { fftOrder };
+    juce::dsp::WindowingFunction<float> window { (size_t) fftSize, juce::dsp::WindowingFunction<float>::hann };
+
+    std::vector<float> history;     // Circular, the last fftSize samples
+    std::vector<float> fftData;     // Twice fftSize, as the FFT needs
+    std::vector<float> spectrum;    // Decibels per bin, with a slow release
+    int historyPosition = 0;
+    bool hasNewSamples = false;
+    double spectrumRate = 48000.0;
+
+    std::vector<BiquadCoefficients<double>> eqSections;
+    double eqRate = 48000.0;
+
+    juce::Image background;
+    juce::Path spectrumPath, eqPath;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpectrumDisplay)
+};
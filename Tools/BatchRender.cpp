@@ -0,0 +1,311 @@
+/*
+    Headless batch renderer for the vinyl chain.
+
+    Usage:
+        VinylBatchRender --output <dir> [--preset <preset.json>] [--seed <n>] [--threads <n>]
+                         [--block <samples>] [--asset-cache <dir>] <files...>
+
+    The preset is a JSON object mapping parameter IDs to plain values, e.g.
+        { "VOLUME": 0.8, "FIRST_EQ": 0.5 }
+    A preset that can't be read or parsed stops the tool with an error.
+
+    Every worker thread owns one VinylAudioProcessor and pulls files from a
+    shared queue. Each file is rendered from a freshly prepared processor with
+    the same noise seed (1 unless --seed is given), so the output does not
+    depend on which worker picked it up and is identical between runs.
+
+    --asset-cache keeps the precomputed tables (crackle banks, EQ coefficient
+    tables) in <dir>, creating it if needed, so later runs map them instead of
+    building them again.
+*/
+
+#include <JuceHeader.h>
+#include <iostream>
+#include "../PluginProcessor.h"
+
+namespace
+{
+    struct RenderSettings
+    {
+        juce::File outputDirectory;
+        juce::var preset;
+        juce::uint32 seed = 1;
+        int blockSize = 4096;
+    };
+
+    struct RenderResult
+    {
+        juce::File file;
+        juce::String error;
+        double audioSeconds = 0.0;
+        double processSeconds = 0.0;
+    };
+
+    //==============================================================================
+    void applyPreset(VinylAudioProcessor& processor, const juce::var& preset)
+    {
+        if (auto* object = preset.getDynamicObject())
+        {
+            for (auto& property : object->getProperties())
+            {
+                if (auto* parameter = processor.getParameters().getParameter(property.name.toString()))
+                    parameter->setValueNotifyingHost(parameter->convertTo0to1((float) property.value));
+            }
+        }
+    }
+
+    RenderResult renderFile(VinylAudioProcessor& processor, juce::AudioFormatManager& formats,
+                            const juce::File& file, const RenderSettings& settings)
+    {
+        RenderResult result;
+        result.file = file;
+
+        std::unique_ptr<juce::AudioFormatReader> reader(formats.createReaderFor(file));
+
+        if (reader == nullptr)
+        {
+            result.error = "unsupported or unreadable file";
+            return result;
+        }
+
+        const auto numChannels = (int) reader->numChannels;
+        const auto sampleRate = reader->sampleRate;
+        const auto channelSet = juce::AudioChannelSet::canonicalChannelSet(numChannels);
+
+        juce::AudioProcessor::BusesLayout layout;
+        layout.inputBuses.add(channelSet);
+        layout.outputBuses.add(channelSet);
+
+        if (channelSet.isDisabled() || ! processor.setBusesLayout(layout))
+        {
+            result.error = "unsupported channel count (" + juce::String(numChannels) + ")";
+            return result;
+        }
+
+        // Parameters first: prepareToPlay designs the filters from them
+        applyPreset(processor, settings.preset);
+        processor.setRandomSeed(settings.seed);
+
+        processor.setNonRealtime(true);
+        processor.setRateAndBufferSizeDetails(sampleRate, settings.blockSize);
+        processor.prepareToPlay(sampleRate, settings.blockSize);
+
+        auto* format = formats.findFormatForFileExtension(file.getFileExtension());
+        auto outputFile = settings.outputDirectory.getChildFile(file.getFileName());
+        outputFile.deleteFile();
+
+        auto stream = outputFile.createOutputStream();
+        std::unique_ptr<juce::AudioFormatWriter> writer;
+
+        if (format != nullptr && stream != nullptr)
+            writer.reset(format->createWriterFor(stream.get(), sampleRate, (unsigned int) numChannels,
+                                                 (int) reader->bitsPerSample, {}, 0));
+
+        if (writer == nullptr)
+        {
+            result.error = "can't write " + outputFile.getFullPathName();
+            processor.releaseResources();
+            return result;
+        }
+
+        stream.release(); // Now owned by the writer
+
+        // Render the latency and the tail past the end of the input, then drop
+        // the latency so the output lines up with the source
+        const auto latency = (juce::int64) processor.getLatencySamples();
+        const auto tail = (juce::int64) std::ceil(processor.getTailLengthSeconds() * sampleRate);
+        const auto totalSamples = reader->lengthInSamples + latency + tail;
+        auto samplesToSkip = latency;
+
+        juce::AudioBuffer<float> buffer(numChannels, settings.blockSize);
+        juce::MidiBuffer midi;
+
+        for (juce::int64 position = 0; position < totalSamples; position += settings.blockSize)
+        {
+            const auto numSamples = (int) juce::jmin((juce::int64) settings.blockSize, totalSamples - position);
+
+            buffer.setSize(numChannels, numSamples, false, false, true);
+            reader->read(&buffer, 0, numSamples, position, true, true);
+
+            const auto start = juce::Time::getMillisecondCounterHiRes();
+            processor.processBlock(buffer, midi);
+            result.processSeconds += (juce::Time::getMillisecondCounterHiRes() - start) * 0.001;
+
+            const auto skip = (int) juce::jmin(samplesToSkip, (juce::int64) numSamples);
+            samplesToSkip -= skip;
+
+            if (skip < numSamples)
+                writer->writeFromAudioSampleBuffer(buffer, skip, numSamples - skip);
+        }
+
+        processor.releaseResources();
+        result.audioSeconds = (double) reader->lengthInSamples / sampleRate;
+        return result;
+    }
+
+    //==============================================================================
+    class RenderWorker : public juce::ThreadPoolJob
+    {
+    public:
+        RenderWorker(const juce::Array<juce::File>& filesToRender, std::vector<RenderResult>& resultsToFill,
+                     std::atomic<int>& sharedNextFile, const RenderSettings& renderSettings)
+            : juce::ThreadPoolJob("Vinyl render worker"),
+              files(filesToRender), results(resultsToFill), nextFile(sharedNextFile), settings(renderSettings)
+        {
+        }
+
+        JobStatus runJob() override
+        {
+            VinylAudioProcessor processor;
+            juce::AudioFormatManager formats;
+            formats.registerBasicFormats();
+
+            while (! shouldExit())
+            {
+                const auto index = nextFile++;
+
+                if (index >= files.size())
+                    break;
+
+                results[(size_t) index] = renderFile(processor, formats, files[index], settings);
+            }
+
+            return jobHasFinished;
+        }
+
+    private:
+        const juce::Array<juce::File>& files;
+        std::vector<RenderResult>& results;
+        std::atomic<int>& nextFile;
+        const RenderSettings& settings;
+    };
+
+    int printUsage()
+    {
+        std::cerr << "Usage: VinylBatchRender --output <dir> [--preset <preset.json>] [--seed <n>] "
+                     "[--threads <n>] [--block <samples>] [--asset-cache <dir>] <files...>" << std::endl;
+        return 1;
+    }
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args(argc, argv);
+
+    RenderSettings settings;
+    auto numThreads = juce::SystemStats::getNumCpus();
+    juce::Array<juce::File> files;
+    juce::File assetCacheDirectory;
+
+    for (int i = 0; i < args.size(); ++i)
+    {
+        const auto& arg = args[i];
+        const auto hasValue = i + 1 < args.size();
+
+        if (arg == "--output" && hasValue)
+            settings.outputDirectory = args[++i].resolveAsFile();
+        else if (arg == "--preset" && hasValue)
+        {
+            const auto presetFile = args[++i].resolveAsFile();
+
+            if (! presetFile.existsAsFile())
+            {
+                std::cerr << "Can't read " << presetFile.getFullPathName() << std::endl;
+                return 1;
+            }
+
+            const auto result = juce::JSON::parse(presetFile.loadFileAsString(), settings.preset);
+
+            if (result.failed() || ! settings.preset.isObject())
+            {
+                std::cerr << presetFile.getFullPathName() << ": "
+                          << (result.failed() ? result.getErrorMessage() : juce::String("not a JSON object")) << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--seed" && hasValue)
+            settings.seed = (juce::uint32) args[++i].text.getLargeIntValue();
+        else if (arg == "--threads" && hasValue)
+            numThreads = juce::jmax(1, args[++i].text.getIntValue());
+        else if (arg == "--block" && hasValue)
+            settings.blockSize = juce::jmax(1, args[++i].text.getIntValue());
+        else if (arg == "--asset-cache" && hasValue)
+            assetCacheDirectory = args[++i].resolveAsFile();
+        else if (arg.isShortOption() || arg.isLongOption())
+            return printUsage();
+        else
+            files.add(arg.resolveAsFile());
+    }
+
+    if (files.isEmpty() || settings.outputDirectory == juce::File())
+        return printUsage();
+
+    if (! settings.outputDirectory.createDirectory())
+    {
+        std::cerr << "Can't create " << settings.outputDirectory.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    if (assetCacheDirectory != juce::File())
+    {
+        if (! assetCacheDirectory.createDirectory())
+        {
+            std::cerr << "Can't create " << assetCacheDirectory.getFullPathName() << std::endl;
+            return 1;
+        }
+
+        SharedAssets::setCacheDirectory(assetCacheDirectory);
+    }
+
+    numThreads = juce::jmin(numThreads, files.size());
+
+    std::vector<RenderResult> results((size_t) files.size());
+    std::atomic<int> nextFile { 0 };
+
+    juce::OwnedArray<RenderWorker> workers;
+    juce::ThreadPool pool(numThreads);
+
+    const auto start = juce::Time::getMillisecondCounterHiRes();
+
+    for (int i = 0; i < numThreads; ++i)
+        pool.addJob(workers.add(new RenderWorker(files, results, nextFile, settings)), false);
+
+    for (auto* worker : workers)
+        pool.waitForJobToFinish(worker, -1);
+
+    const auto wallSeconds = (juce::Time::getMillisecondCounterHiRes() - start) * 0.001;
+
+    //==============================================================================
+    double totalAudioSeconds = 0.0, totalProcessSeconds = 0.0;
+    int numFailed = 0;
+
+    for (auto& result : results)
+    {
+        if (result.error.isNotEmpty())
+        {
+            std::cerr << result.file.getFileName() << ": " << result.error << std::endl;
+            ++numFailed;
+            continue;
+        }
+
+        totalAudioSeconds += result.audioSeconds;
+        totalProcessSeconds += result.processSeconds;
+
+        std::cout << result.file.getFileName() << ": " << juce::String(result.audioSeconds, 2) << " s, "
+                  << juce::String(result.audioSeconds / juce::jmax(1.0e-9, result.processSeconds), 1)
+                  << "x realtime" << std::endl;
+    }
+
+    std::cout << "Rendered " << (files.size() - numFailed) << " of " << files.size() << " files ("
+              << juce::String(totalAudioSeconds, 1) << " s of audio) in " << juce::String(wallSeconds, 2)
+              << " s on " << numThreads << " threads" << std::endl
+              << "Realtime factor per core: "
+              << juce::String(totalAudioSeconds / juce::jmax(1.0e-9, wallSeconds * numThreads), 1)
+              << "x including I/O, "
+              << juce::String(totalAudioSeconds / juce::jmax(1.0e-9, totalProcessSeconds), 1)
+              << "x in processBlock" << std::endl;
+
+    return numFailed == 0 ? 0 : 1;
+}
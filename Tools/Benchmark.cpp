@@ -0,0 +1,2880 @@
+/*
+    Benchmark and profiling harness for VinylAudioProcessor.
+
+    Usage:
+        VinylBenchmark [--suites <suite,...>] [--block-sizes 16,64,...]
+                       [--rates 44100,...] [--channels 1,2] [--seconds <per case>]
+                       [--instances <n>] [--json <file>] [--label <text>]
+                       [--rt-report <file>] [--golden <dir> [--update-golden]]
+                       [--golden-tolerance <dB>]
+
+    Every suite runs unless --suites picks some of them.
+
+    processBlock: every case is a fresh processor prepared for one block size,
+    sample rate, channel count and parameter setting, fed white noise. Only
+    processBlock is timed. For profiling, run a single case for a long time, e.g.
+        VinylBenchmark --suites processBlock --block-sizes 512 --rates 48000 --channels 2 --seconds 60
+
+    aliasing: drives a sine hard into the saturation stage at each
+    oversampling setting and reports everything that is not a harmonic.
+
+    interpolation: times the wobble stage on its own with each delay line
+    interpolation mode, at every sample rate and channel count.
+
+    load: what a host does when it opens a project, for --instances instances
+    (500 by default): construct, restore a saved state, prepareToPlay.
+
+    idle: 200 instances of which only one in ten gets any input, as on a
+    session full of idle tracks, to see what the silence bypass saves.
+
+    automation: the same chain with static parameters and with every
+    continuous parameter automated by a slow sweep, at each block size.
+
+    eqTables: for each sample rate and EQ control, how far the interpolated
+    coefficient tables are from designing the filters directly, as the worst
+    coefficient difference and the worst magnitude response difference in dB,
+    and what a lookup and a design cost. Both are compared in double, so they
+    measure the tables rather than float rounding; any control beyond 1e-4
+    or 0.01 dB fails, and makes the harness exit with 1.
+
+    memory: resident memory per instance for --instances instances with every
+    stage on (Linux only), and the size of the assets they share, next to what
+    each instance would hold with a private copy of them.
+
+    channels: the EQ alone and the whole chain (wobble linked and unlinked)
+    on 1 to 16 channels, as ns per sample and per channel, to show how the
+    channel-vectorised filtering scales.
+
+    cascade: the volume and all five EQ sections run the old way, a volume
+    loop and then one ProcessorChain pass per section, against GainStage
+    and the fused cascade, at 32, 128 and 1024 samples in mono and stereo.
+    Reports ns per sample for each, the speedup and the largest difference
+    between their outputs.
+
+    gain: the volume stage alone at each block size and channel count,
+    settled at unity, settled at 0.5 and ramping, next to the per-sample
+    loop it replaced. Then steps VOLUME from 0.5 to 1 through the processor
+    at every rate and block size, with DC in: no two output samples may be
+    more than 1/100 of the step apart, or the harness exits with 1.
+
+    precision: float against double processing at each sample rate: the
+    whole chain's cost, the EQ's noise floor against a long double reference,
+    and how far one coefficient rounding step moves the EQ's response.
+
+    metering: what the editor's meters and spectrum cost the audio thread, as
+    a share of the block budget: the whole chain with the editor closed and
+    open, and AnalysisFeed::push on its own, which must stay under 1% at
+    every setting or the harness exits with 1.
+
+    linearPhase: the EQ alone in minimum phase (IIR) and linear phase (FIR
+    convolution) mode, at each block size from 64 to 1024 and sample rate, with
+    the latency each mode reports.
+
+    quality: the whole chain with every stage a quality mode changes switched
+    on, in the Eco, Normal and High modes, with the latency each reports.
+
+    realtime: in a -DVINYL_RT_CHECKS=ON build, runs every block size, rate,
+    channel count and both precisions with everything on, with the linear
+    phase EQ, with each oversampling mode, and with every choice parameter
+    switching while it plays, delivered on the audio thread as a VST3 host
+    delivers automation, feeding the meters and going in and out of the
+    silence bypass. Any allocation, free or lock on the audio thread is printed
+    with its stack and makes the harness exit with 1, for CI. Then, for each
+    block size, rate and channel count, a second thread writes the volume and
+    EQ parameters as fast as it can while blocks run; the output must stay
+    bounded and, once the writes stop, settle onto a processor prepared with
+    the final values, or the harness exits with 1 too. --rt-report writes
+    the violations and a histogram of the suite's block times to a file.
+    Other builds skip it.
+
+    golden: renders an impulse, a sweep and noise through several settings at
+    44.1 and 96 kHz, offline, at both precisions. Each render must repeat
+    exactly, and must match its reference in --golden <dir> (references go in
+    Tests/golden in the source tree) to within --golden-tolerance dB (-90 by
+    default); the table shows which match bit for bit. A missing reference
+    fails. --update-golden writes the references instead, from a build
+    known to be good. It also measures the EQ's response to an impulse and
+    checks it against the curves the filters are designed for (the 80 Hz
+    high-pass, 325 Hz peak and 10 kHz roll-off, and both cuts) within 0.1 dB.
+    Any failure makes the harness exit with 1.
+
+    hostPatterns: the whole chain with static settings, prepared for 512
+    samples and called the ways hosts split the stream: 512 and 64 aligned,
+    1, 37 and 333 samples, random sizes up to 1024, 2048 (more than was
+    prepared) and alternating 1 and 1023. Reports the cost, the worst call
+    against the audio it covers, and how far the output is from the 512
+    render, which it should match exactly.
+
+    engine: a RenderEngine with two instances per CPU, each rendering
+    --seconds of stereo offline, on 1, 2, 4 ... threads up to every CPU. The
+    work is the same at every thread count, so speedup and efficiency show
+    where scaling stops: with the default padded arena and one reused block
+    per instance; with 100-sample blocks padded and packed, where packed
+    instances share cache lines; streaming through a whole render held in
+    the arena, which is bound by memory bandwidth sooner; and with the
+    workers unpinned. Also reports each job's mean and worst latency from
+    the start of its cycle and the share of jobs stolen by another worker.
+*/
+
+#include <JuceHeader.h>
+#include <chrono>
+#include <complex>
+#include <iostream>
+#include "../PluginProcessor.h"
+#include "../RenderEngine.h"
+
+namespace
+{
+    struct Options
+    {
+        juce::StringArray suites;   // Empty runs all of them
+        juce::Array<int> blockSizes { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+        juce::Array<double> sampleRates { 44100.0, 48000.0, 88200.0, 96000.0, 176400.0, 192000.0 };
+        juce::Array<int> channelCounts { 1, 2 };
+        double secondsPerCase = 1.0;
+        int numInstances = 500;
+        juce::File jsonFile;
+        juce::String label;
+        juce::File rtReportFile;
+        juce::File goldenDirectory;
+        bool updateGolden = false;
+        double goldenToleranceDecibels = -90.0;
+    };
+
+    // Set by the suites that check (eqTables, gain, metering, realtime,
+    // golden) when a check fails; the harness then exits with 1
+    bool checksFailed = false;
+
+    // A named set of parameter values, applied before prepareToPlay
+    struct Setting
+    {
+        juce::String name;
+        std::vector<std::pair<juce::String, float>> parameters;
+    };
+
+    struct BenchmarkCase
+    {
+        Setting setting;
+        int blockSize = 0;
+        double sampleRate = 0.0;
+        int numChannels = 0;
+        bool analysis = false;      // Feed the meters and spectrum, as with the editor open
+    };
+
+    struct BenchmarkResult
+    {
+        BenchmarkCase benchmarkCase;
+        double nsPerSample = 0.0;           // Per sample frame, all channels
+        double meanBlockMicroseconds = 0.0;
+        double worstBlockMicroseconds = 0.0;
+        double budgetPercent = 0.0;         // Mean block time / block duration
+        double worstBudgetPercent = 0.0;
+        int latencySamples = 0;             // As reported to the host
+    };
+
+    //==============================================================================
+    juce::String getOversamplingName(int oversampling, int filter)
+    {
+        return juce::String(1 << oversampling) + "x" + (oversampling == 0 ? "" : filter == 0 ? " min" : " linear");
+    }
+
+    // Every combination of the three EQ sections, at unity and non-unity volume,
+    // then each crackle preset, each saturation oversampling mode and wobble on its own
+    std::vector<Setting> makeSettings()
+    {
+        std::vector<Setting> settings;
+
+        for (auto volume : { 1.0f, 0.5f })
+        {
+            for (int mask = 0; mask < 8; ++mask)
+            {
+                Setting setting;
+                juce::StringArray sections;
+
+                if (mask & 1) sections.add("first");
+                if (mask & 2) sections.add("lowcut");
+                if (mask & 4) sections.add("highcut");
+
+                setting.name = "eq=" + (sections.isEmpty() ? juce::String("off") : sections.joinIntoString("+"))
+                             + " volume=" + juce::String(volume, 1);
+
+                setting.parameters = { { "VOLUME", volume },
+                                       { "FIRST_EQ", (mask & 1) ? 0.5f : 0.0f },
+                                       { "LOW_CUT", (mask & 2) ? 0.5f : 0.0f },
+                                       { "HIGH_CUT", (mask & 4) ? 0.5f : 0.0f },
+                                       { "CRACKLE_DENSITY", 0.0f },
+                                       { "CRACKLE_LEVEL", 0.0f } };
+                settings.push_back(setting);
+            }
+        }
+
+        for (auto& preset : VinylAudioProcessor::cracklePresets)
+        {
+            if (preset.density <= 0.0f)
+                continue;
+
+            settings.push_back({ "crackle=" + juce::String(preset.name).upToFirstOccurrenceOf(" ", false, false).toLowerCase(),
+                                 { { "VOLUME", 1.0f },
+                                   { "CRACKLE_DENSITY", preset.density },
+                                   { "CRACKLE_LEVEL", preset.level } } });
+        }
+
+        for (int oversampling = 0; oversampling < 3; ++oversampling)
+        {
+            for (int filter = 0; filter < (oversampling == 0 ? 1 : 2); ++filter)
+            {
+                settings.push_back({ "saturation " + getOversamplingName(oversampling, filter),
+                                     { { "VOLUME", 1.0f },
+                                       { "CRACKLE_DENSITY", 0.0f },
+                                       { "SATURATION", 0.5f },
+                                       { "OVERSAMPLING", (float) oversampling },
+                                       { "OVERSAMPLING_FILTER", (float) filter } } });
+            }
+        }
+
+        settings.push_back({ "wobble", { { "VOLUME", 1.0f },
+                                         { "CRACKLE_DENSITY", 0.0f },
+                                         { "WOBBLE", 0.5f } } });
+
+        return settings;
+    }
+
+    //==============================================================================
+    bool prepareProcessor(VinylAudioProcessor& processor, const BenchmarkCase& benchmarkCase)
+    {
+        const auto channelSet = juce::AudioChannelSet::canonicalChannelSet(benchmarkCase.numChannels);
+
+        juce::AudioProcessor::BusesLayout layout;
+        layout.inputBuses.add(channelSet);
+        layout.outputBuses.add(channelSet);
+
+        if (channelSet.isDisabled() || ! processor.setBusesLayout(layout))
+            return false;
+
+        for (auto& [id, value] : benchmarkCase.setting.parameters)
+            if (auto* parameter = processor.getParameters().getParameter(id))
+                parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+
+        processor.setRandomSeed(1);
+        processor.getAnalysisFeed().setEnabled(benchmarkCase.analysis);
+
+        processor.setRateAndBufferSizeDetails(benchmarkCase.sampleRate, benchmarkCase.blockSize);
+        processor.prepareToPlay(benchmarkCase.sampleRate, benchmarkCase.blockSize);
+        return true;
+    }
+
+    void drainAnalysisFeed(AnalysisFeed& feed)
+    {
+        AnalysisFeed::Levels levels;
+        float samples[1024];
+
+        while (feed.readLevels(&levels, 1) > 0) {}
+        while (feed.readSamples(samples, (int) std::size(samples)) > 0) {}
+    }
+
+    // Times processBlock for one case, at float or double precision
+    template <typename SampleType = float>
+    BenchmarkResult runCase(const BenchmarkCase& benchmarkCase, double seconds)
+    {
+        using Clock = std::chrono::steady_clock;
+
+        BenchmarkResult result;
+        result.benchmarkCase = benchmarkCase;
+
+        VinylAudioProcessor processor;
+
+        if constexpr (std::is_same_v<SampleType, double>)
+            processor.setProcessingPrecision(juce::AudioProcessor::doublePrecision);
+
+        if (! prepareProcessor(processor, benchmarkCase))
+            return result;
+
+        result.latencySamples = processor.getLatencySamples();
+
+        const auto blockSize = benchmarkCase.blockSize;
+        const auto numChannels = benchmarkCase.numChannels;
+
+        juce::AudioBuffer<SampleType> input(numChannels, blockSize), buffer(numChannels, blockSize);
+        juce::MidiBuffer midi;
+        juce::Random random(1);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            for (int i = 0; i < blockSize; ++i)
+                input.setSample(channel, i, (SampleType) (random.nextFloat() - 0.5f));
+
+        const auto numBlocks = juce::jmax(16, (int) std::ceil(seconds * benchmarkCase.sampleRate / blockSize));
+        const auto numWarmupBlocks = numBlocks / 10 + 1;
+
+        double totalSeconds = 0.0, worstSeconds = 0.0;
+
+        for (int block = 0; block < numWarmupBlocks + numBlocks; ++block)
+        {
+            for (int channel = 0; channel < numChannels; ++channel)
+                buffer.copyFrom(channel, 0, input, channel, 0, blockSize);
+
+            const auto start = Clock::now();
+            processor.processBlock(buffer, midi);
+            const auto elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+            if (block >= numWarmupBlocks)
+            {
+                totalSeconds += elapsed;
+                worstSeconds = juce::jmax(worstSeconds, elapsed);
+            }
+
+            // Drain the feed like the editor's timer, so pushes don't find it full
+            if (benchmarkCase.analysis)
+                drainAnalysisFeed(processor.getAnalysisFeed());
+        }
+
+        processor.releaseResources();
+
+        const auto blockDuration = blockSize / benchmarkCase.sampleRate;
+        const auto meanSeconds = totalSeconds / numBlocks;
+
+        result.nsPerSample = totalSeconds * 1.0e9 / ((double) numBlocks * blockSize);
+        result.meanBlockMicroseconds = meanSeconds * 1.0e6;
+        result.worstBlockMicroseconds = worstSeconds * 1.0e6;
+        result.budgetPercent = 100.0 * meanSeconds / blockDuration;
+        result.worstBudgetPercent = 100.0 * worstSeconds / blockDuration;
+        return result;
+    }
+
+    //==============================================================================
+    juce::var toVar(const BenchmarkResult& result)
+    {
+        auto* object = new juce::DynamicObject();
+        const auto& benchmarkCase = result.benchmarkCase;
+
+        object->setProperty("setting", benchmarkCase.setting.name);
+        object->setProperty("blockSize", benchmarkCase.blockSize);
+        object->setProperty("sampleRate", benchmarkCase.sampleRate);
+        object->setProperty("channels", benchmarkCase.numChannels);
+        object->setProperty("nsPerSample", result.nsPerSample);
+        object->setProperty("meanBlockMicroseconds", result.meanBlockMicroseconds);
+        object->setProperty("worstBlockMicroseconds", result.worstBlockMicroseconds);
+        object->setProperty("budgetPercent", result.budgetPercent);
+        object->setProperty("worstBudgetPercent", result.worstBudgetPercent);
+        object->setProperty("latencySamples", result.latencySamples);
+        return juce::var(object);
+    }
+
+    void printResult(const BenchmarkResult& result)
+    {
+        const auto& benchmarkCase = result.benchmarkCase;
+
+        std::cout << benchmarkCase.setting.name.paddedRight(' ', 34)
+                  << juce::String(benchmarkCase.blockSize).paddedLeft(' ', 6)
+                  << juce::String(benchmarkCase.sampleRate, 0).paddedLeft(' ', 8)
+                  << juce::String(benchmarkCase.numChannels).paddedLeft(' ', 4)
+                  << juce::String(result.nsPerSample, 2).paddedLeft(' ', 12)
+                  << juce::String(result.worstBlockMicroseconds, 1).paddedLeft(' ', 12)
+                  << juce::String(result.budgetPercent, 3).paddedLeft(' ', 10)
+                  << juce::String(result.worstBudgetPercent, 2).paddedLeft(' ', 10) << std::endl;
+    }
+
+    template <typename Type>
+    juce::Array<Type> parseList(const juce::String& text)
+    {
+        juce::Array<Type> values;
+
+        for (auto& token : juce::StringArray::fromTokens(text, ",", ""))
+            values.add((Type) token.getDoubleValue());
+
+        return values;
+    }
+
+    //==============================================================================
+    juce::var runProcessBlockSuite(const Options& options)
+    {
+        std::cout << juce::String("setting").paddedRight(' ', 34) << " block    rate  ch   ns/sample"
+                     "  worst (us)  budget %   worst %" << std::endl;
+
+        juce::Array<juce::var> results;
+
+        for (auto& setting : makeSettings())
+        {
+            for (auto numChannels : options.channelCounts)
+            {
+                for (auto sampleRate : options.sampleRates)
+                {
+                    for (auto blockSize : options.blockSizes)
+                    {
+                        const auto result = runCase({ setting, blockSize, sampleRate, numChannels }, options.secondsPerCase);
+                        printResult(result);
+                        results.add(toVar(result));
+                    }
+                }
+            }
+        }
+
+        return results;
+    }
+
+    // Everything in the spectrum of a saturated sine that is not the fundamental
+    // or one of its harmonics, relative to the fundamental
+    juce::var runAliasingSuite(const Options&)
+    {
+        constexpr int fftOrder = 15;
+        constexpr int fftSize = 1 << fftOrder;
+        constexpr int blockSize = 512;
+        constexpr double sampleRate = 44100.0;
+
+        // Close to 5 kHz and centred on a bin, so no energy leaks between bins
+        constexpr int fundamentalBin = 3715;
+        constexpr int binTolerance = 8;
+        const auto frequency = fundamentalBin * sampleRate / fftSize;
+
+        std::cout << "oversampling       aliasing (dB)" << std::endl;
+
+        juce::Array<juce::var> results;
+        juce::dsp::FFT fft(fftOrder);
+        juce::dsp::WindowingFunction<float> window((size_t) fftSize, juce::dsp::WindowingFunction<float>::blackmanHarris, false);
+
+        for (int oversampling = 0; oversampling < 3; ++oversampling)
+        {
+            for (int filter = 0; filter < (oversampling == 0 ? 1 : 2); ++filter)
+            {
+                const Setting setting { "aliasing", { { "VOLUME", 1.0f },
+                                                      { "CRACKLE_DENSITY", 0.0f },
+                                                      { "SATURATION", 1.0f },
+                                                      { "OVERSAMPLING", (float) oversampling },
+                                                      { "OVERSAMPLING_FILTER", (float) filter } } };
+                VinylAudioProcessor processor;
+                prepareProcessor(processor, { setting, blockSize, sampleRate, 1 });
+
+                // A few blocks to let the filters settle, then analyse the last fftSize samples
+                const auto numSamples = fftSize + 8 * blockSize;
+                std::vector<float> output((size_t) numSamples), spectrum((size_t) fftSize * 2);
+                juce::AudioBuffer<float> buffer(1, blockSize);
+                juce::MidiBuffer midi;
+
+                for (int start = 0; start < numSamples; start += blockSize)
+                {
+                    for (int i = 0; i < blockSize; ++i)
+                        buffer.setSample(0, i, 0.9f * (float) std::sin(juce::MathConstants<double>::twoPi * frequency * (start + i) / sampleRate));
+
+                    processor.processBlock(buffer, midi);
+                    std::copy(buffer.getReadPointer(0), buffer.getReadPointer(0) + blockSize, output.begin() + start);
+                }
+
+                std::copy(output.end() - fftSize, output.end(), spectrum.begin());
+                window.multiplyWithWindowingTable(spectrum.data(), (size_t) fftSize);
+                fft.performFrequencyOnlyForwardTransform(spectrum.data(), true);
+
+                double fundamentalPower = 0.0, aliasPower = 0.0;
+
+                // Bins below binTolerance are DC and the EQ's low end, not aliasing
+                for (int bin = binTolerance; bin <= fftSize / 2; ++bin)
+                {
+                    const auto power = (double) spectrum[(size_t) bin] * spectrum[(size_t) bin];
+                    const auto harmonic = juce::roundToInt((double) bin / fundamentalBin);
+                    const auto isHarmonic = harmonic >= 1 && std::abs(bin - harmonic * fundamentalBin) <= binTolerance;
+
+                    if (isHarmonic && harmonic == 1)
+                        fundamentalPower += power;
+                    else if (! isHarmonic)
+                        aliasPower += power;
+                }
+
+                const auto aliasingDb = 10.0 * std::log10(juce::jmax(1.0e-30, aliasPower) / juce::jmax(1.0e-30, fundamentalPower));
+                const auto name = getOversamplingName(oversampling, filter);
+
+                std::cout << name.paddedRight(' ', 19) << juce::String(aliasingDb, 1) << std::endl;
+
+                auto* object = new juce::DynamicObject();
+                object->setProperty("oversampling", name);
+                object->setProperty("aliasingDb", aliasingDb);
+                results.add(juce::var(object));
+            }
+        }
+
+        return results;
+    }
+
+    juce::var runInterpolationSuite(const Options& options)
+    {
+        using Wobble = WowFlutter<float>;
+        using Clock = std::chrono::steady_clock;
+
+        const std::pair<const char*, Wobble::Interpolation> modes[] =
+        {
+            { "linear",   Wobble::Interpolation::linear },
+            { "lagrange", Wobble::Interpolation::lagrange },
+            { "allpass",  Wobble::Interpolation::allpass }
+        };
+
+        // The processor hands the stage one sub-block at a time
+        constexpr int blockSize = BiquadCascade<float>::subBlockSize;
+
+        std::cout << "interpolation    rate  ch   ns/sample" << std::endl;
+
+        juce::Array<juce::var> results;
+
+        for (auto& [name, mode] : modes)
+        {
+            for (auto numChannels : options.channelCounts)
+            {
+                for (auto sampleRate : options.sampleRates)
+                {
+                    Wobble wobble;
+                    wobble.prepare({ sampleRate, (juce::uint32) blockSize, (juce::uint32) numChannels });
+                    wobble.setInterpolation(mode);
+                    wobble.setAmount(1.0f);
+
+                    juce::AudioBuffer<float> buffer(numChannels, blockSize);
+                    juce::Random random(1);
+
+                    for (int channel = 0; channel < numChannels; ++channel)
+                        for (int i = 0; i < blockSize; ++i)
+                            buffer.setSample(channel, i, random.nextFloat() - 0.5f);
+
+                    juce::dsp::AudioBlock<float> block(buffer);
+                    juce::dsp::ProcessContextReplacing<float> context(block);
+
+                    // The output is fed straight back in; the stage is unity gain, so it stays bounded
+                    const auto numBlocks = juce::jmax(16, (int) std::ceil(options.secondsPerCase * sampleRate / blockSize));
+
+                    for (int i = 0; i < numBlocks / 10 + 1; ++i)
+                        wobble.process(context);
+
+                    const auto start = Clock::now();
+
+                    for (int i = 0; i < numBlocks; ++i)
+                        wobble.process(context);
+
+                    const auto seconds = std::chrono::duration<double>(Clock::now() - start).count();
+                    const auto nsPerSample = seconds * 1.0e9 / ((double) numBlocks * blockSize);
+
+                    std::cout << juce::String(name).paddedRight(' ', 13)
+                              << juce::String(sampleRate, 0).paddedLeft(' ', 8)
+                              << juce::String(numChannels).paddedLeft(' ', 4)
+                              << juce::String(nsPerSample, 2).paddedLeft(' ', 12) << std::endl;
+
+                    auto* object = new juce::DynamicObject();
+                    object->setProperty("interpolation", juce::String(name));
+                    object->setProperty("sampleRate", sampleRate);
+                    object->setProperty("channels", numChannels);
+                    object->setProperty("nsPerSample", nsPerSample);
+                    results.add(juce::var(object));
+                }
+            }
+        }
+
+        return results;
+    }
+
+    juce::var runLoadSuite(const Options& options)
+    {
+        using Clock = std::chrono::steady_clock;
+
+        constexpr double sampleRate = 48000.0;
+        constexpr int blockSize = 512;
+
+        // A state with every section in use
+        juce::MemoryBlock state;
+        {
+            const Setting setting { "load", { { "VOLUME", 0.8f },
+                                              { "EQ_MODE", 1.0f },
+                                              { "FIRST_EQ", 0.5f },
+                                              { "CRACKLE_DENSITY", 8.0f },
+                                              { "CRACKLE_LEVEL", 0.12f },
+                                              { "SATURATION", 0.5f },
+                                              { "WOBBLE", 0.5f } } };
+            VinylAudioProcessor processor;
+
+            for (auto& [id, value] : setting.parameters)
+                if (auto* parameter = processor.getParameters().getParameter(id))
+                    parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+
+            processor.getStateInformation(state);
+        }
+
+        const auto numInstances = options.numInstances;
+        std::vector<std::unique_ptr<VinylAudioProcessor>> processors;
+        processors.reserve((size_t) numInstances);
+
+        auto measure = [](auto&& function)
+        {
+            const auto start = Clock::now();
+            function();
+            return std::chrono::duration<double>(Clock::now() - start).count();
+        };
+
+        const auto constructSeconds = measure([&]
+        {
+            for (int i = 0; i < numInstances; ++i)
+                processors.push_back(std::make_unique<VinylAudioProcessor>());
+        });
+
+        const auto restoreSeconds = measure([&]
+        {
+            for (auto& processor : processors)
+                processor->setStateInformation(state.getData(), (int) state.getSize());
+        });
+
+        const auto prepareSeconds = measure([&]
+        {
+            for (auto& processor : processors)
+            {
+                processor->setRateAndBufferSizeDetails(sampleRate, blockSize);
+                processor->prepareToPlay(sampleRate, blockSize);
+            }
+        });
+
+        struct Phase
+        {
+            const char* name;
+            const char* key;
+            double seconds;
+        };
+
+        const Phase phases[] =
+        {
+            { "construct",     "constructMs", constructSeconds },
+            { "restore state", "restoreMs",   restoreSeconds },
+            { "prepare",       "prepareMs",   prepareSeconds },
+            { "total",         "totalMs",     constructSeconds + restoreSeconds + prepareSeconds }
+        };
+
+        std::cout << numInstances << " instances, state " << (int) state.getSize() << " bytes" << std::endl
+                  << "phase            total (ms)  per instance (us)" << std::endl;
+
+        auto* object = new juce::DynamicObject();
+        object->setProperty("instances", numInstances);
+        object->setProperty("stateBytes", (int) state.getSize());
+
+        for (auto& phase : phases)
+        {
+            std::cout << juce::String(phase.name).paddedRight(' ', 15)
+                      << juce::String(phase.seconds * 1.0e3, 2).paddedLeft(' ', 12)
+                      << juce::String(phase.seconds * 1.0e6 / numInstances, 1).paddedLeft(' ', 19) << std::endl;
+
+            object->setProperty(phase.key, phase.seconds * 1.0e3);
+        }
+
+        return juce::var(object);
+    }
+
+    juce::var runIdleSuite(const Options& options)
+    {
+        using Clock = std::chrono::steady_clock;
+
+        constexpr int numInstances = 200;
+        constexpr int numPlaying = 20;
+        constexpr int blockSize = 512;
+        constexpr int numChannels = 2;
+        constexpr double sampleRate = 48000.0;
+
+        // A typical chain without crackle, which would keep every instance busy
+        const Setting setting { "idle", { { "VOLUME", 0.8f },
+                                          { "FIRST_EQ", 0.5f },
+                                          { "CRACKLE_DENSITY", 0.0f },
+                                          { "SATURATION", 0.3f },
+                                          { "WOBBLE", 0.3f } } };
+
+        std::vector<std::unique_ptr<VinylAudioProcessor>> processors;
+
+        for (int i = 0; i < numInstances; ++i)
+        {
+            processors.push_back(std::make_unique<VinylAudioProcessor>());
+            prepareProcessor(*processors.back(), { setting, blockSize, sampleRate, numChannels });
+        }
+
+        juce::AudioBuffer<float> noise(numChannels, blockSize), buffer(numChannels, blockSize);
+        juce::MidiBuffer midi;
+        juce::Random random(1);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            for (int i = 0; i < blockSize; ++i)
+                noise.setSample(channel, i, random.nextFloat() - 0.5f);
+
+        const auto numBlocks = juce::jmax(16, (int) std::ceil(options.secondsPerCase * sampleRate / blockSize));
+        double playingSeconds = 0.0, idleSeconds = 0.0;
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            for (int i = 0; i < numInstances; ++i)
+            {
+                const auto isPlaying = i < numPlaying;
+
+                for (int channel = 0; channel < numChannels; ++channel)
+                {
+                    if (isPlaying)
+                        buffer.copyFrom(channel, 0, noise, channel, 0, blockSize);
+                    else
+                        buffer.clear(channel, 0, blockSize);
+                }
+
+                const auto start = Clock::now();
+                processors[(size_t) i]->processBlock(buffer, midi);
+                const auto elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+                (isPlaying ? playingSeconds : idleSeconds) += elapsed;
+            }
+        }
+
+        juce::int64 skippedBlocks = 0;
+
+        for (auto& processor : processors)
+            skippedBlocks += processor->getNumSkippedBlocks();
+
+        const auto numIdleBlocks = (double) numBlocks * (numInstances - numPlaying);
+        const auto playingMicroseconds = playingSeconds * 1.0e6 / ((double) numBlocks * numPlaying);
+        const auto idleMicroseconds = idleSeconds * 1.0e6 / numIdleBlocks;
+        const auto skippedPercent = 100.0 * (double) skippedBlocks / numIdleBlocks;
+
+        std::cout << numInstances << " instances, " << numPlaying << " playing, " << numBlocks << " blocks of "
+                  << blockSize << std::endl
+                  << "playing: " << juce::String(playingMicroseconds, 2) << " us/block" << std::endl
+                  << "idle:    " << juce::String(idleMicroseconds, 2) << " us/block, "
+                  << juce::String(skippedPercent, 1) << "% of blocks skipped" << std::endl;
+
+        auto* object = new juce::DynamicObject();
+        object->setProperty("instances", numInstances);
+        object->setProperty("playing", numPlaying);
+        object->setProperty("playingBlockMicroseconds", playingMicroseconds);
+        object->setProperty("idleBlockMicroseconds", idleMicroseconds);
+        object->setProperty("skippedPercent", skippedPercent);
+        return juce::var(object);
+    }
+
+    juce::var runAutomationSuite(const Options& options)
+    {
+        using Clock = std::chrono::steady_clock;
+
+        constexpr double sampleRate = 48000.0;
+        constexpr int numChannels = 2;
+        constexpr double sweepHz = 0.5;
+
+        const Setting setting { "automation", { { "VOLUME", 0.8f },
+                                                { "FIRST_EQ", 0.5f },
+                                                { "LOW_CUT", 0.5f },
+                                                { "HIGH_CUT", 0.5f },
+                                                { "CRACKLE_DENSITY", 0.0f },
+                                                { "SATURATION", 0.5f },
+                                                { "WOBBLE", 0.5f } } };
+
+        std::cout << "block   static ns/sample   automated ns/sample   overhead %" << std::endl;
+
+        juce::Array<juce::var> results;
+
+        for (auto blockSize : options.blockSizes)
+        {
+            double nsPerSample[2] {};
+
+            for (auto automate : { false, true })
+            {
+                VinylAudioProcessor processor;
+                prepareProcessor(processor, { setting, blockSize, sampleRate, numChannels });
+
+                std::vector<juce::RangedAudioParameter*> automated;
+
+                for (auto& [id, value] : setting.parameters)
+                    if (id != "CRACKLE_DENSITY")
+                        automated.push_back(processor.getParameters().getParameter(id));
+
+                juce::AudioBuffer<float> input(numChannels, blockSize), buffer(numChannels, blockSize);
+                juce::MidiBuffer midi;
+                juce::Random random(1);
+
+                for (int channel = 0; channel < numChannels; ++channel)
+                    for (int i = 0; i < blockSize; ++i)
+                        input.setSample(channel, i, random.nextFloat() - 0.5f);
+
+                const auto numBlocks = juce::jmax(16, (int) std::ceil(options.secondsPerCase * sampleRate / blockSize));
+                double totalSeconds = 0.0;
+
+                for (int block = 0; block < numBlocks; ++block)
+                {
+                    // Each parameter sweeps 0.1 ... 0.9 with its own phase, like a host
+                    // playing back automation lanes
+                    if (automate)
+                    {
+                        const auto phase = juce::MathConstants<double>::twoPi * sweepHz * block * blockSize / sampleRate;
+
+                        for (size_t i = 0; i < automated.size(); ++i)
+                            automated[i]->setValueNotifyingHost((float) (0.5 + 0.4 * std::sin(phase + (double) i)));
+                    }
+
+                    for (int channel = 0; channel < numChannels; ++channel)
+                        buffer.copyFrom(channel, 0, input, channel, 0, blockSize);
+
+                    const auto start = Clock::now();
+                    processor.processBlock(buffer, midi);
+                    totalSeconds += std::chrono::duration<double>(Clock::now() - start).count();
+                }
+
+                nsPerSample[automate ? 1 : 0] = totalSeconds * 1.0e9 / ((double) numBlocks * blockSize);
+            }
+
+            const auto overheadPercent = 100.0 * (nsPerSample[1] / juce::jmax(1.0e-9, nsPerSample[0]) - 1.0);
+
+            std::cout << juce::String(blockSize).paddedLeft(' ', 5)
+                      << juce::String(nsPerSample[0], 2).paddedLeft(' ', 19)
+                      << juce::String(nsPerSample[1], 2).paddedLeft(' ', 22)
+                      << juce::String(overheadPercent, 1).paddedLeft(' ', 13) << std::endl;
+
+            auto* object = new juce::DynamicObject();
+            object->setProperty("blockSize", blockSize);
+            object->setProperty("staticNsPerSample", nsPerSample[0]);
+            object->setProperty("automatedNsPerSample", nsPerSample[1]);
+            object->setProperty("overheadPercent", overheadPercent);
+            results.add(juce::var(object));
+        }
+
+        return results;
+    }
+
+    // Magnitude response of a chain of biquads, in decibels
+    template <typename CoefficientType>
+    double getMagnitudeDecibels(const BiquadCoefficients<CoefficientType>* sections, int numSections,
+                                double frequency, double sampleRate)
+    {
+        return juce::Decibels::gainToDecibels(BiquadDesign::getMagnitude(sections, numSections, frequency, sampleRate), -200.0);
+    }
+
+    juce::var runEQTablesSuite(const Options& options)
+    {
+        using EQ = VinylEQ<float>;
+        using Clock = std::chrono::steady_clock;
+
+        constexpr int numValues = 4001;         // Mostly between table entries
+        constexpr int numFrequencies = 200;     // Log spaced, 20 Hz to just below Nyquist
+        const char* controlNames[] = { "first", "lowcut", "highcut" };
+
+        // Every control's table must stay this close to its design
+        constexpr double maxCoefficientTolerance = 1.0e-4;
+        constexpr double maxResponseToleranceDecibels = 0.01;
+
+        auto anyFailed = false;
+
+        std::cout << "rate     control   max coefficient error   max response error dB   lookup ns   design ns" << std::endl;
+
+        juce::Array<juce::var> results;
+
+        for (auto sampleRate : options.sampleRates)
+        {
+            for (int c = 0; c < EQ::numControls; ++c)
+            {
+                const auto control = (EQ::Control) c;
+                const auto numSections = EQ::getNumSections(control);
+                const EQ::CoefficientTable table(control, sampleRate);
+                const VinylEQ<double>::CoefficientTable doubleTable(control, sampleRate);
+                const auto maxFrequency = 0.45 * sampleRate;
+
+                double maxCoefficientError = 0.0, maxResponseError = 0.0;
+
+                for (int i = 1; i < numValues; ++i)
+                {
+                    const auto value = (double) i / (numValues - 1);
+                    BiquadCoefficients<double> looked[EQ::maxSectionsPerControl], designed[EQ::maxSectionsPerControl];
+
+                    doubleTable.lookup(value, looked);
+                    EQ::design(control, sampleRate, value, designed);
+
+                    for (int s = 0; s < numSections; ++s)
+                    {
+                        const auto& a = looked[s];
+                        const auto& b = designed[s];
+
+                        maxCoefficientError = juce::jmax(maxCoefficientError,
+                                                         std::abs(a.b0 - b.b0), std::abs(a.b1 - b.b1), std::abs(a.b2 - b.b2));
+                        maxCoefficientError = juce::jmax(maxCoefficientError,
+                                                         std::abs(a.a1 - b.a1), std::abs(a.a2 - b.a2));
+                    }
+
+                    for (int f = 0; f < numFrequencies; ++f)
+                    {
+                        const auto frequency = 20.0 * std::pow(maxFrequency / 20.0, (double) f / (numFrequencies - 1));
+                        const auto error = std::abs(getMagnitudeDecibels(looked, numSections, frequency, sampleRate)
+                                                    - getMagnitudeDecibels(designed, numSections, frequency, sampleRate));
+                        maxResponseError = juce::jmax(maxResponseError, error);
+                    }
+                }
+
+                // What one coefficient update costs on the audio thread, before and after
+                BiquadCoefficients<float> sections[EQ::maxSectionsPerControl];
+                float checksum = 0.0f;
+
+                auto start = Clock::now();
+
+                for (int i = 0; i < numValues; ++i)
+                {
+                    table.lookup((float) i / (numValues - 1), sections);
+                    checksum += sections[0].b0;
+                }
+
+                const auto lookupNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / numValues;
+
+                start = Clock::now();
+
+                for (int i = 0; i < numValues; ++i)
+                {
+                    EQ::design(control, sampleRate, (double) i / (numValues - 1), sections);
+                    checksum += sections[0].b0;
+                }
+
+                const auto designNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / numValues;
+
+                // Keeps the timed loops from being optimised away
+                volatile float sink = checksum;
+                juce::ignoreUnused(sink);
+
+                const auto failed = maxCoefficientError > maxCoefficientTolerance
+                                     || maxResponseError > maxResponseToleranceDecibels;
+                anyFailed = anyFailed || failed;
+
+                std::cout << juce::String(sampleRate, 0).paddedRight(' ', 9)
+                          << juce::String(controlNames[c]).paddedRight(' ', 10)
+                          << juce::String(maxCoefficientError, 10).paddedLeft(' ', 21)
+                          << juce::String(maxResponseError, 4).paddedLeft(' ', 24)
+                          << juce::String(lookupNs, 1).paddedLeft(' ', 12)
+                          << juce::String(designNs, 1).paddedLeft(' ', 12)
+                          << (failed ? "   FAILED" : "") << std::endl;
+
+                auto* object = new juce::DynamicObject();
+                object->setProperty("sampleRate", sampleRate);
+                object->setProperty("control", controlNames[c]);
+                object->setProperty("maxCoefficientError", maxCoefficientError);
+                object->setProperty("maxResponseErrorDecibels", maxResponseError);
+                object->setProperty("lookupNs", lookupNs);
+                object->setProperty("designNs", designNs);
+                object->setProperty("passed", ! failed);
+                results.add(juce::var(object));
+            }
+        }
+
+        std::cout << (anyFailed ? "FAILED: a coefficient table strays from its design"
+                                : "passed: every coefficient table matches its design") << std::endl;
+
+        checksFailed = checksFailed || anyFailed;
+        return results;
+    }
+
+    // Resident memory of this process, where the platform makes it easy to read
+    juce::int64 getResidentBytes()
+    {
+       #if JUCE_LINUX
+        for (auto& line : juce::StringArray::fromLines(juce::File("/proc/self/status").loadFileAsString()))
+            if (line.startsWith("VmRSS:"))
+                return line.fromFirstOccurrenceOf(":", false, false).trim().getLargeIntValue() * 1024;
+       #endif
+
+        return 0;
+    }
+
+    juce::var runMemorySuite(const Options& options)
+    {
+        constexpr double sampleRate = 48000.0;
+        constexpr int blockSize = 512;
+        constexpr int numChannels = 2;
+
+        // Every stage that uses shared assets switched on
+        const Setting setting { "memory", { { "FIRST_EQ", 0.5f },
+                                            { "LOW_CUT", 0.5f },
+                                            { "HIGH_CUT", 0.5f },
+                                            { "SATURATION", 0.5f },
+                                            { "WOBBLE", 0.5f } } };
+
+        const auto numInstances = options.numInstances;
+        const auto residentBefore = getResidentBytes();
+
+        std::vector<std::unique_ptr<VinylAudioProcessor>> processors;
+
+        for (int i = 0; i < numInstances; ++i)
+        {
+            processors.push_back(std::make_unique<VinylAudioProcessor>());
+            prepareProcessor(*processors.back(), { setting, blockSize, sampleRate, numChannels });
+        }
+
+        const auto residentAfter = getResidentBytes();
+        const auto sharedBytes = (juce::int64) SharedAssets::getTotalBytes();
+        const auto mappedBytes = (juce::int64) SharedAssets::getTotalBytes(true);
+
+        // Before the cache every instance held its own copy of every asset
+        const auto perInstance = residentBefore > 0 ? (double) (residentAfter - residentBefore) / numInstances : 0.0;
+        const auto perInstanceWithPrivateAssets = perInstance + (double) sharedBytes * (numInstances - 1) / numInstances;
+
+        std::cout << numInstances << " instances at " << sampleRate << " Hz" << std::endl
+                  << "shared assets:              " << juce::String(sharedBytes / 1024.0, 1) << " KB, "
+                  << juce::String(mappedBytes / 1024.0, 1) << " KB mapped from disk" << std::endl;
+
+        if (residentBefore > 0)
+            std::cout << "per instance:               " << juce::String(perInstance / 1024.0, 1) << " KB" << std::endl
+                      << "per instance, private copy: " << juce::String(perInstanceWithPrivateAssets / 1024.0, 1)
+                      << " KB" << std::endl;
+        else
+            std::cout << "resident memory isn't available on this platform" << std::endl;
+
+        auto* object = new juce::DynamicObject();
+        object->setProperty("instances", numInstances);
+        object->setProperty("sharedAssetBytes", sharedBytes);
+        object->setProperty("mappedAssetBytes", mappedBytes);
+        object->setProperty("bytesPerInstance", perInstance);
+        object->setProperty("bytesPerInstanceWithPrivateAssets", perInstanceWithPrivateAssets);
+        return juce::var(object);
+    }
+
+    juce::var runChannelsSuite(const Options& options)
+    {
+        constexpr double sampleRate = 48000.0;
+        constexpr int blockSize = 512;
+
+        const Setting settings[] =
+        {
+            { "eq", { { "FIRST_EQ", 0.5f },
+                      { "LOW_CUT", 0.5f },
+                      { "HIGH_CUT", 0.5f },
+                      { "CRACKLE_DENSITY", 0.0f } } },
+            { "full chain", { { "FIRST_EQ", 0.5f },
+                              { "LOW_CUT", 0.5f },
+                              { "HIGH_CUT", 0.5f },
+                              { "SATURATION", 0.5f },
+                              { "WOBBLE", 0.5f } } },
+            { "full chain, wobble unlinked", { { "FIRST_EQ", 0.5f },
+                                               { "LOW_CUT", 0.5f },
+                                               { "HIGH_CUT", 0.5f },
+                                               { "SATURATION", 0.5f },
+                                               { "WOBBLE", 0.5f },
+                                               { "WOBBLE_LINK", 0.0f } } }
+        };
+
+        std::cout << "setting                           channels   ns/sample   ns/sample/channel" << std::endl;
+
+        juce::Array<juce::var> results;
+
+        for (auto& setting : settings)
+        {
+            for (int numChannels = 1; numChannels <= VinylAudioProcessor::maxChannels; ++numChannels)
+            {
+                const auto result = runCase({ setting, blockSize, sampleRate, numChannels }, options.secondsPerCase);
+                const auto nsPerChannel = result.nsPerSample / numChannels;
+
+                std::cout << setting.name.paddedRight(' ', 34)
+                          << juce::String(numChannels).paddedLeft(' ', 8)
+                          << juce::String(result.nsPerSample, 2).paddedLeft(' ', 12)
+                          << juce::String(nsPerChannel, 2).paddedLeft(' ', 20) << std::endl;
+
+                auto* object = new juce::DynamicObject();
+                object->setProperty("setting", setting.name);
+                object->setProperty("channels", numChannels);
+                object->setProperty("nsPerSample", result.nsPerSample);
+                object->setProperty("nsPerSamplePerChannel", nsPerChannel);
+                results.add(juce::var(object));
+            }
+        }
+
+        return results;
+    }
+
+    //==============================================================================
+    // Largest sample difference between two buffers, or infinity if their sizes differ
+    template <typename SampleType, typename OtherType>
+    double getMaxDifference(const juce::AudioBuffer<SampleType>& a, const juce::AudioBuffer<OtherType>& b)
+    {
+        if (a.getNumChannels() != b.getNumChannels() || a.getNumSamples() != b.getNumSamples())
+            return std::numeric_limits<double>::infinity();
+
+        double difference = 0.0;
+
+        for (int channel = 0; channel < a.getNumChannels(); ++channel)
+            for (int i = 0; i < a.getNumSamples(); ++i)
+                difference = juce::jmax(difference, std::abs((double) a.getSample(channel, i) - (double) b.getSample(channel, i)));
+
+        return difference;
+    }
+
+    // The EQ the way processBlock ran it before the fused cascade: a per-sample
+    // volume loop, then every section in its own ProcessorChain pass
+    class SeparateChains
+    {
+    public:
+        static constexpr int numSections = 5;
+
+        void prepare(const juce::dsp::ProcessSpec& spec, float newVolume,
+                     const std::array<BiquadCoefficients<double>, numSections>& sections)
+        {
+            volume = newVolume;
+
+            for (size_t i = 0; i < chains.size(); ++i)
+            {
+                const auto& k = sections[i];
+                *chains[i].get<0>().state = juce::dsp::IIR::Coefficients<float>((float) k.b0, (float) k.b1, (float) k.b2,
+                                                                                 1.0f, (float) k.a1, (float) k.a2);
+                chains[i].prepare(spec);
+            }
+        }
+
+        void process(juce::AudioBuffer<float>& buffer)
+        {
+            for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+            {
+                auto* channelData = buffer.getWritePointer(channel);
+
+                for (int sample = 0; sample < buffer.getNumSamples(); ++sample)
+                    channelData[sample] *= volume;
+            }
+
+            juce::dsp::AudioBlock<float> block(buffer);
+
+            for (auto& chain : chains)
+                chain.process(juce::dsp::ProcessContextReplacing<float>(block));
+        }
+
+    private:
+        using Filter = juce::dsp::IIR::Filter<float>;
+        using FilterDuplicator = juce::dsp::ProcessorDuplicator<Filter, juce::dsp::IIR::Coefficients<float>>;
+
+        std::array<juce::dsp::ProcessorChain<FilterDuplicator>, numSections> chains;
+        float volume = 1.0f;
+    };
+
+    // Volume and every EQ section, as separate chains and as the fused
+    // cascade (GainStage and VinylEQ over 64-sample chunks, as VinylChain runs
+    // them), at 32, 128 and 1024 samples in mono and stereo. Only the
+    // processing is timed; each block gets fresh noise. The outputs must
+    // match to float rounding.
+    juce::var runCascadeSuite(const Options& options)
+    {
+        using Clock = std::chrono::steady_clock;
+        using EQ = VinylEQ<float>;
+
+        constexpr double sampleRate = 48000.0;
+        constexpr float volume = 0.8f, eqValue = 0.5f;
+        constexpr int chunkSize = BiquadCascade<float>::subBlockSize;
+
+        // Sections in the cascade's order: low cut, high cut, then the Vinyl EQ's three
+        std::array<BiquadCoefficients<double>, SeparateChains::numSections> sections;
+        EQ::design(EQ::lowCut, sampleRate, eqValue, &sections[0]);
+        EQ::design(EQ::highCut, sampleRate, eqValue, &sections[1]);
+        EQ::design(EQ::firstEQ, sampleRate, eqValue, &sections[2]);
+
+        juce::ScopedNoDenormals noDenormals;
+
+        std::cout << "block  ch   separate ns/sample   fused ns/sample   speedup    max diff" << std::endl;
+
+        juce::Array<juce::var> results;
+
+        for (auto blockSize : { 32, 128, 1024 })
+        {
+            for (auto numChannels : { 1, 2 })
+            {
+                const juce::dsp::ProcessSpec spec { sampleRate, (juce::uint32) blockSize, (juce::uint32) numChannels };
+                const juce::dsp::ProcessSpec chunkSpec { sampleRate, (juce::uint32) chunkSize, (juce::uint32) numChannels };
+
+                SeparateChains separate;
+                separate.prepare(spec, volume, sections);
+
+                GainStage<float> gain;
+                EQ eq;
+                gain.setGain(volume);
+                eq.setFirstEQ(eqValue);
+                eq.setLowCut(eqValue);
+                eq.setHighCut(eqValue);
+                gain.prepare(chunkSpec);
+                eq.prepare(chunkSpec);
+
+                const auto numBlocks = juce::jmax(1, juce::roundToInt(options.secondsPerCase * sampleRate / blockSize));
+
+                juce::AudioBuffer<float> input(numChannels, blockSize), separateBuffer(numChannels, blockSize),
+                                         fusedBuffer(numChannels, blockSize);
+                juce::Random random(1);
+                double separateSeconds = 0.0, fusedSeconds = 0.0, maxDifference = 0.0;
+
+                for (int i = 0; i < numBlocks; ++i)
+                {
+                    for (int channel = 0; channel < numChannels; ++channel)
+                        for (int n = 0; n < blockSize; ++n)
+                            input.setSample(channel, n, random.nextFloat() - 0.5f);
+
+                    separateBuffer.makeCopyOf(input, true);
+                    fusedBuffer.makeCopyOf(input, true);
+
+                    auto start = Clock::now();
+                    separate.process(separateBuffer);
+                    separateSeconds += std::chrono::duration<double>(Clock::now() - start).count();
+
+                    start = Clock::now();
+                    juce::dsp::AudioBlock<float> block(fusedBuffer);
+
+                    for (int chunkStart = 0; chunkStart < blockSize; chunkStart += chunkSize)
+                    {
+                        auto chunk = block.getSubBlock((size_t) chunkStart, (size_t) juce::jmin(chunkSize, blockSize - chunkStart));
+                        const juce::dsp::ProcessContextReplacing<float> context(chunk);
+                        gain.process(context);
+                        eq.process(context);
+                    }
+
+                    fusedSeconds += std::chrono::duration<double>(Clock::now() - start).count();
+                    maxDifference = juce::jmax(maxDifference, getMaxDifference(separateBuffer, fusedBuffer));
+                }
+
+                const auto numSamples = (double) numBlocks * blockSize;
+                const auto separateNs = separateSeconds * 1.0e9 / numSamples;
+                const auto fusedNs = fusedSeconds * 1.0e9 / numSamples;
+                const auto speedup = separateNs / juce::jmax(1.0e-9, fusedNs);
+
+                std::cout << juce::String(blockSize).paddedLeft(' ', 5)
+                          << juce::String(numChannels).paddedLeft(' ', 4)
+                          << juce::String(separateNs, 2).paddedLeft(' ', 21)
+                          << juce::String(fusedNs, 2).paddedLeft(' ', 18)
+                          << (juce::String(speedup, 2) + "x").paddedLeft(' ', 10)
+                          << juce::String(maxDifference, 8).paddedLeft(' ', 12) << std::endl;
+
+                auto* object = new juce::DynamicObject();
+                object->setProperty("blockSize", blockSize);
+                object->setProperty("channels", numChannels);
+                object->setProperty("separateNsPerSample", separateNs);
+                object->setProperty("fusedNsPerSample", fusedNs);
+                object->setProperty("speedup", speedup);
+                object->setProperty("maxDifference", maxDifference);
+                results.add(juce::var(object));
+            }
+        }
+
+        return results;
+    }
+
+    // GainStage on its own at each block size and channel count: settled at
+    // 1, where it does nothing, settled at 0.5, and always ramping, next to the
+    // per-sample loop processBlock used to run. Then a check that a VOLUME
+    // step from 0.5 to 1 through the processor doesn't click.
+    juce::var runGainSuite(const Options& options)
+    {
+        using Clock = std::chrono::steady_clock;
+
+        constexpr double sampleRate = 48000.0;
+
+        juce::ScopedNoDenormals noDenormals;
+
+        std::cout << "block  ch   old loop ns   unity ns   constant ns   ramping ns" << std::endl;
+
+        juce::Array<juce::var> results;
+
+        for (auto numChannels : options.channelCounts)
+        {
+            for (auto blockSize : options.blockSizes)
+            {
+                const auto numBlocks = juce::jmax(1, juce::roundToInt(options.secondsPerCase * sampleRate / blockSize));
+                const auto numSamples = (double) numBlocks * blockSize;
+
+                juce::AudioBuffer<float> buffer(numChannels, blockSize);
+                juce::Random random(1);
+
+                for (int channel = 0; channel < numChannels; ++channel)
+                    for (int i = 0; i < blockSize; ++i)
+                        buffer.setSample(channel, i, random.nextFloat() - 0.5f);
+
+                auto timeNs = [&](auto&& processBuffer)
+                {
+                    const auto start = Clock::now();
+
+                    for (int i = 0; i < numBlocks; ++i)
+                        processBuffer(i);
+
+                    return std::chrono::duration<double>(Clock::now() - start).count() * 1.0e9 / numSamples;
+                };
+
+                // The raw parameter read for every sample
+                std::atomic<float> volume { 0.5f };
+                auto* volumeParameter = &volume;
+
+                const auto oldLoopNs = timeNs([&](int)
+                {
+                    for (int channel = 0; channel < numChannels; ++channel)
+                    {
+                        auto* channelData = buffer.getWritePointer(channel);
+
+                        for (int sample = 0; sample < blockSize; ++sample)
+                            channelData[sample] *= *volumeParameter;
+                    }
+                });
+
+                double stageNs[3] {};
+
+                for (int mode = 0; mode < 3; ++mode)
+                {
+                    GainStage<float> gain;
+                    gain.setGain(mode == 0 ? 1.0f : 0.5f);
+                    gain.prepare({ sampleRate, (juce::uint32) blockSize, (juce::uint32) numChannels });
+
+                    juce::dsp::AudioBlock<float> block(buffer);
+                    const juce::dsp::ProcessContextReplacing<float> context(block);
+
+                    stageNs[mode] = timeNs([&](int i)
+                    {
+                        // A new target every block keeps the ramp going
+                        if (mode == 2)
+                            gain.setGain(i % 2 == 0 ? 1.0f : 0.5f);
+
+                        gain.process(context);
+                    });
+                }
+
+                std::cout << juce::String(blockSize).paddedLeft(' ', 5)
+                          << juce::String(numChannels).paddedLeft(' ', 4)
+                          << juce::String(oldLoopNs, 3).paddedLeft(' ', 14)
+                          << juce::String(stageNs[0], 3).paddedLeft(' ', 11)
+                          << juce::String(stageNs[1], 3).paddedLeft(' ', 14)
+                          << juce::String(stageNs[2], 3).paddedLeft(' ', 13) << std::endl;
+
+                auto* object = new juce::DynamicObject();
+                object->setProperty("blockSize", blockSize);
+                object->setProperty("channels", numChannels);
+                object->setProperty("oldLoopNsPerSample", oldLoopNs);
+                object->setProperty("unityNsPerSample", stageNs[0]);
+                object->setProperty("constantNsPerSample", stageNs[1]);
+                object->setProperty("rampingNsPerSample", stageNs[2]);
+                results.add(juce::var(object));
+            }
+        }
+
+        // DC in, so every change between output samples comes from the gain.
+        // Unsmoothed, the step is one jump of 0.25; it must be spread over at
+        // least 100 samples.
+        constexpr float input = 0.5f, stepFrom = 0.5f, stepTo = 1.0f;
+        constexpr double maxJump = input * (stepTo - stepFrom) / 100.0;
+        auto clicked = false;
+
+        std::cout << std::endl << "VOLUME 0.5 to 1     block    rate   largest jump   final" << std::endl;
+
+        for (auto rate : options.sampleRates)
+        {
+            for (auto blockSize : options.blockSizes)
+            {
+                const Setting setting { "volume step", { { "VOLUME", stepFrom },
+                                                         { "CRACKLE_DENSITY", 0.0f },
+                                                         { "CRACKLE_LEVEL", 0.0f } } };
+
+                VinylAudioProcessor processor;
+
+                if (! prepareProcessor(processor, { setting, blockSize, rate, 1 }))
+                    continue;
+
+                juce::AudioBuffer<float> buffer(1, blockSize);
+                juce::MidiBuffer midi;
+                const auto numBlocks = juce::jmax(2, juce::roundToInt(0.2 * rate / blockSize));
+                auto previous = input * stepFrom;
+                double largestJump = 0.0;
+
+                for (int block = 0; block < numBlocks; ++block)
+                {
+                    if (block == numBlocks / 2)
+                    {
+                        auto* parameter = processor.getParameters().getParameter("VOLUME");
+                        parameter->setValueNotifyingHost(parameter->convertTo0to1(stepTo));
+                    }
+
+                    juce::FloatVectorOperations::fill(buffer.getWritePointer(0), input, blockSize);
+                    processor.processBlock(buffer, midi);
+
+                    for (int i = 0; i < blockSize; ++i)
+                    {
+                        const auto sample = buffer.getSample(0, i);
+                        largestJump = juce::jmax(largestJump, (double) std::abs(sample - previous));
+                        previous = sample;
+                    }
+                }
+
+                // The ramp must also arrive
+                const auto failed = largestJump > maxJump || std::abs(previous - input * stepTo) > 1.0e-6f;
+                clicked = clicked || failed;
+
+                std::cout << juce::String("").paddedRight(' ', 15)
+                          << juce::String(blockSize).paddedLeft(' ', 10)
+                          << juce::String(rate, 0).paddedLeft(' ', 8)
+                          << juce::String(largestJump, 6).paddedLeft(' ', 15)
+                          << juce::String(previous, 4).paddedLeft(' ', 8)
+                          << (failed ? "  FAILED" : "") << std::endl;
+
+                auto* object = new juce::DynamicObject();
+                object->setProperty("check", "volume step");
+                object->setProperty("blockSize", blockSize);
+                object->setProperty("sampleRate", rate);
+                object->setProperty("largestJump", largestJump);
+                object->setProperty("passed", ! failed);
+                results.add(juce::var(object));
+            }
+        }
+
+        std::cout << (clicked ? "FAILED: the volume step clicked"
+                              : "passed: the volume step ramps without clicks") << std::endl;
+
+        checksFailed = checksFailed || clicked;
+        return results;
+    }
+
+    // Every EQ section on, with the low cut near 80 Hz where it is hardest to get
+    // right. The values sit on coefficient table entries, so the lookups are
+    // exact and only the arithmetic differs between precisions.
+    constexpr float precisionEQValues[] = { 0.5f, 20.0f / 1024.0f, 0.5f };     // Vinyl EQ, Low Cut, High Cut
+
+    // Error of VinylEQ at this precision against the same filters run in long
+    // double with double coefficients, in dB relative to the output
+    template <typename SampleType>
+    double measureNoiseFloor(double sampleRate)
+    {
+        using EQ = VinylEQ<SampleType>;
+
+        const auto numSamples = (int) sampleRate;
+        constexpr int numChannels = 2;  // Goes through the SIMD kernel
+        constexpr int blockSize = 512;
+
+        EQ eq;
+        eq.setFirstEQ((SampleType) precisionEQValues[EQ::firstEQ]);
+        eq.setLowCut((SampleType) precisionEQValues[EQ::lowCut]);
+        eq.setHighCut((SampleType) precisionEQValues[EQ::highCut]);
+        eq.prepare({ sampleRate, (juce::uint32) blockSize, (juce::uint32) numChannels });
+
+        juce::AudioBuffer<SampleType> buffer(numChannels, numSamples);
+        std::vector<long double> reference((size_t) numSamples);
+        juce::Random random(1);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto x = (SampleType) (0.5f * (random.nextFloat() * 2.0f - 1.0f));
+            buffer.setSample(0, i, x);
+            buffer.setSample(1, i, x);
+            reference[(size_t) i] = (long double) x;
+        }
+
+        juce::dsp::AudioBlock<SampleType> block(buffer);
+
+        for (int start = 0; start < numSamples; start += blockSize)
+        {
+            auto subBlock = block.getSubBlock((size_t) start, (size_t) juce::jmin(blockSize, numSamples - start));
+            eq.process(juce::dsp::ProcessContextReplacing<SampleType>(subBlock));
+        }
+
+        for (int c = 0; c < VinylEQ<double>::numControls; ++c)
+        {
+            const auto control = (typename VinylEQ<double>::Control) c;
+            BiquadCoefficients<double> sections[VinylEQ<double>::maxSectionsPerControl];
+            VinylEQ<double>::design(control, sampleRate, (double) precisionEQValues[c], sections);
+
+            for (int s = 0; s < VinylEQ<double>::getNumSections(control); ++s)
+            {
+                const auto& k = sections[s];
+                long double s1 = 0, s2 = 0;
+
+                for (auto& x : reference)
+                {
+                    const auto y = x * k.b0 + s1;
+                    s1 = x * k.b1 - y * k.a1 + s2;
+                    s2 = x * k.b2 - y * k.a2;
+                    x = y;
+                }
+            }
+        }
+
+        long double errorEnergy = 0, signalEnergy = 0;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto error = (long double) buffer.getSample(0, i) - reference[(size_t) i];
+            errorEnergy += error * error;
+            signalEnergy += reference[(size_t) i] * reference[(size_t) i];
+        }
+
+        return 10.0 * std::log10((double) (errorEnergy / signalEnergy) + 1.0e-300);
+    }
+
+    // Largest change in any EQ section's magnitude response, in dB, when one
+    // coefficient moves by one unit in the last place at this precision.
+    // Checked at both ends of every control's range.
+    template <typename SampleType>
+    double measureCoefficientSensitivity(double sampleRate)
+    {
+        using EQ = VinylEQ<SampleType>;
+        constexpr int numFrequencies = 200;
+
+        double worst = 0.0;
+
+        for (int c = 0; c < EQ::numControls; ++c)
+        {
+            for (auto value : { 0.0, 1.0 })
+            {
+                BiquadCoefficients<SampleType> sections[EQ::maxSectionsPerControl];
+                EQ::design((typename EQ::Control) c, sampleRate, value, sections);
+
+                for (int s = 0; s < EQ::getNumSections((typename EQ::Control) c); ++s)
+                {
+                    for (auto member : { &BiquadCoefficients<SampleType>::b0, &BiquadCoefficients<SampleType>::b1,
+                                         &BiquadCoefficients<SampleType>::b2, &BiquadCoefficients<SampleType>::a1,
+                                         &BiquadCoefficients<SampleType>::a2 })
+                    {
+                        auto nudged = sections[s];
+                        nudged.*member = std::nextafter(nudged.*member, std::numeric_limits<SampleType>::infinity());
+
+                        for (int f = 0; f < numFrequencies; ++f)
+                        {
+                            const auto frequency = 20.0 * std::pow(0.45 * sampleRate / 20.0, (double) f / (numFrequencies - 1));
+                            const auto change = std::abs(getMagnitudeDecibels(&nudged, 1, frequency, sampleRate)
+                                                         - getMagnitudeDecibels(&sections[s], 1, frequency, sampleRate));
+                            worst = juce::jmax(worst, change);
+                        }
+                    }
+                }
+            }
+        }
+
+        return worst;
+    }
+
+    juce::var runPrecisionSuite(const Options& options)
+    {
+        constexpr int blockSize = 512;
+        constexpr int numChannels = 2;
+
+        const Setting setting { "full chain", { { "FIRST_EQ", precisionEQValues[0] },
+                                                { "LOW_CUT", precisionEQValues[1] },
+                                                { "HIGH_CUT", precisionEQValues[2] },
+                                                { "SATURATION", 0.5f },
+                                                { "WOBBLE", 0.5f } } };
+
+        std::cout << "rate     precision   ns/sample   EQ noise floor dB   coefficient sensitivity dB/ulp" << std::endl;
+
+        juce::Array<juce::var> results;
+
+        for (auto sampleRate : options.sampleRates)
+        {
+            for (auto isDouble : { false, true })
+            {
+                const BenchmarkCase benchmarkCase { setting, blockSize, sampleRate, numChannels };
+                const auto result = isDouble ? runCase<double>(benchmarkCase, options.secondsPerCase)
+                                             : runCase<float>(benchmarkCase, options.secondsPerCase);
+                const auto noiseFloor = isDouble ? measureNoiseFloor<double>(sampleRate)
+                                                 : measureNoiseFloor<float>(sampleRate);
+                const auto sensitivity = isDouble ? measureCoefficientSensitivity<double>(sampleRate)
+                                                  : measureCoefficientSensitivity<float>(sampleRate);
+                const auto precision = isDouble ? "double" : "float";
+
+                std::cout << juce::String(sampleRate, 0).paddedRight(' ', 9)
+                          << juce::String(precision).paddedRight(' ', 10)
+                          << juce::String(result.nsPerSample, 2).paddedLeft(' ', 11)
+                          << juce::String(noiseFloor, 1).paddedLeft(' ', 20)
+                          << juce::String(sensitivity, 12).paddedLeft(' ', 33) << std::endl;
+
+                auto* object = new juce::DynamicObject();
+                object->setProperty("sampleRate", sampleRate);
+                object->setProperty("precision", precision);
+                object->setProperty("nsPerSample", result.nsPerSample);
+                object->setProperty("noiseFloorDecibels", noiseFloor);
+                object->setProperty("coefficientSensitivityDecibels", sensitivity);
+                results.add(juce::var(object));
+            }
+        }
+
+        return results;
+    }
+
+    // Mean time AnalysisFeed::push takes for one block of noise
+    double measureAnalysisPushSeconds(int blockSize, double sampleRate, int numChannels, double seconds)
+    {
+        using Clock = std::chrono::steady_clock;
+
+        AnalysisFeed feed;
+        feed.prepare(sampleRate);
+        feed.setEnabled(true);
+
+        juce::AudioBuffer<float> buffer(numChannels, blockSize);
+        juce::Random random(1);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            for (int i = 0; i < blockSize; ++i)
+                buffer.setSample(channel, i, random.nextFloat() - 0.5f);
+
+        const auto numBlocks = juce::jmax(16, (int) std::ceil(seconds * sampleRate / blockSize));
+        double totalSeconds = 0.0;
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            const auto start = Clock::now();
+            feed.push(buffer);
+            totalSeconds += std::chrono::duration<double>(Clock::now() - start).count();
+
+            drainAnalysisFeed(feed);
+        }
+
+        return totalSeconds / numBlocks;
+    }
+
+    juce::var runMeteringSuite(const Options& options)
+    {
+        constexpr double budgetPercentLimit = 1.0;
+
+        const Setting setting { "full chain", { { "FIRST_EQ", 0.5f },
+                                                { "LOW_CUT", 0.5f },
+                                                { "HIGH_CUT", 0.5f },
+                                                { "SATURATION", 0.5f },
+                                                { "WOBBLE", 0.5f } } };
+
+        std::cout << "rate     block   channels   closed %   open %   feed %" << std::endl;
+
+        juce::Array<juce::var> results;
+        double worstFeedPercent = 0.0;
+
+        for (auto sampleRate : options.sampleRates)
+        {
+            for (auto blockSize : options.blockSizes)
+            {
+                for (auto numChannels : options.channelCounts)
+                {
+                    const auto closed = runCase({ setting, blockSize, sampleRate, numChannels, false }, options.secondsPerCase);
+                    const auto open = runCase({ setting, blockSize, sampleRate, numChannels, true }, options.secondsPerCase);
+                    const auto feedSeconds = measureAnalysisPushSeconds(blockSize, sampleRate, numChannels, options.secondsPerCase);
+                    const auto feedPercent = 100.0 * feedSeconds * sampleRate / blockSize;
+                    worstFeedPercent = juce::jmax(worstFeedPercent, feedPercent);
+
+                    std::cout << juce::String(sampleRate, 0).paddedRight(' ', 9)
+                              << juce::String(blockSize).paddedLeft(' ', 5)
+                              << juce::String(numChannels).paddedLeft(' ', 11)
+                              << juce::String(closed.budgetPercent, 3).paddedLeft(' ', 11)
+                              << juce::String(open.budgetPercent, 3).paddedLeft(' ', 9)
+                              << juce::String(feedPercent, 3).paddedLeft(' ', 9)
+                              << (feedPercent < budgetPercentLimit ? "" : "   FAILED") << std::endl;
+
+                    auto* object = new juce::DynamicObject();
+                    object->setProperty("sampleRate", sampleRate);
+                    object->setProperty("blockSize", blockSize);
+                    object->setProperty("channels", numChannels);
+                    object->setProperty("editorClosedBudgetPercent", closed.budgetPercent);
+                    object->setProperty("editorOpenBudgetPercent", open.budgetPercent);
+                    object->setProperty("feedBudgetPercent", feedPercent);
+                    object->setProperty("passed", feedPercent < budgetPercentLimit);
+                    results.add(juce::var(object));
+                }
+            }
+        }
+
+        const auto failed = worstFeedPercent >= budgetPercentLimit;
+
+        std::cout << (failed ? "FAILED: " : "passed: ") << "worst feed cost " << juce::String(worstFeedPercent, 3)
+                  << "% of the block budget (" << (failed ? "over" : "within") << " the "
+                  << budgetPercentLimit << "% limit)" << std::endl;
+
+        checksFailed = checksFailed || failed;
+        return results;
+    }
+
+    juce::var runLinearPhaseSuite(const Options& options)
+    {
+        constexpr int numChannels = 2;
+
+        const std::vector<std::pair<juce::String, float>> eq { { "FIRST_EQ", 0.5f },
+                                                               { "LOW_CUT", 0.5f },
+                                                               { "HIGH_CUT", 0.5f },
+                                                               { "CRACKLE_DENSITY", 0.0f } };
+        Setting minimumPhase { "minimum phase", eq }, linearPhase { "linear phase", eq };
+        linearPhase.parameters.push_back({ "LINEAR_PHASE_EQ", 1.0f });
+
+        std::cout << "rate     block   mode            ns/sample   budget %   latency" << std::endl;
+
+        juce::Array<juce::var> results;
+
+        for (auto sampleRate : options.sampleRates)
+        {
+            for (auto blockSize : options.blockSizes)
+            {
+                if (blockSize < 64 || blockSize > 1024)
+                    continue;
+
+                for (auto* setting : { &minimumPhase, &linearPhase })
+                {
+                    const auto result = runCase({ *setting, blockSize, sampleRate, numChannels }, options.secondsPerCase);
+
+                    std::cout << juce::String(sampleRate, 0).paddedRight(' ', 9)
+                              << juce::String(blockSize).paddedLeft(' ', 5)
+                              << "   " << setting->name.paddedRight(' ', 14)
+                              << juce::String(result.nsPerSample, 2).paddedLeft(' ', 11)
+                              << juce::String(result.budgetPercent, 3).paddedLeft(' ', 11)
+                              << juce::String(result.latencySamples).paddedLeft(' ', 10) << std::endl;
+
+                    results.add(toVar(result));
+                }
+            }
+        }
+
+        return results;
+    }
+
+    juce::var runQualitySuite(const Options& options)
+    {
+        const auto& mediumCrackle = VinylAudioProcessor::cracklePresets[2];
+
+        // Every stage a quality mode touches is on
+        const Setting everything { "", { { "FIRST_EQ", 0.5f },
+                                         { "LOW_CUT", 0.5f },
+                                         { "HIGH_CUT", 0.5f },
+                                         { "LINEAR_PHASE_EQ", 1.0f },
+                                         { "CRACKLE_DENSITY", mediumCrackle.density },
+                                         { "CRACKLE_LEVEL", mediumCrackle.level },
+                                         { "SATURATION", 0.5f },
+                                         { "OVERSAMPLING", 1.0f },
+                                         { "WOBBLE", 0.5f } } };
+
+        const char* const modeNames[] { "Eco", "Normal", "High" };
+
+        std::cout << "rate     block  ch   mode      ns/sample   budget %   worst %   latency" << std::endl;
+
+        juce::Array<juce::var> results;
+
+        for (auto sampleRate : options.sampleRates)
+        {
+            for (auto blockSize : options.blockSizes)
+            {
+                for (auto numChannels : options.channelCounts)
+                {
+                    for (int mode = 0; mode < (int) std::size(modeNames); ++mode)
+                    {
+                        auto setting = everything;
+                        setting.name = modeNames[mode];
+                        setting.parameters.push_back({ "QUALITY", (float) mode });
+
+                        const auto result = runCase({ setting, blockSize, sampleRate, numChannels }, options.secondsPerCase);
+
+                        std::cout << juce::String(sampleRate, 0).paddedRight(' ', 9)
+                                  << juce::String(blockSize).paddedLeft(' ', 5)
+                                  << juce::String(numChannels).paddedLeft(' ', 4)
+                                  << "   " << setting.name.paddedRight(' ', 7)
+                                  << juce::String(result.nsPerSample, 2).paddedLeft(' ', 12)
+                                  << juce::String(result.budgetPercent, 3).paddedLeft(' ', 11)
+                                  << juce::String(result.worstBudgetPercent, 2).paddedLeft(' ', 10)
+                                  << juce::String(result.latencySamples).paddedLeft(' ', 10) << std::endl;
+
+                        results.add(toVar(result));
+                    }
+                }
+            }
+        }
+
+        return results;
+    }
+
+    //==============================================================================
+    // Every block the realtime suite runs, for --rt-report
+    RealtimeChecks::BlockTimeHistogram realtimeBlockTimes;
+
+    // Runs numBlocks blocks with input that alternates between noise and
+    // silence every 50 blocks, so the silence bypass engages and releases, and
+    // with the meters and spectrum fed. Parameters in switches step to their
+    // next value every 10 blocks, delivered as a VST3 host delivers
+    // automation: on the audio thread, just before processBlock, each one set
+    // and its listeners told only if it changed. JUCE's own listener locks
+    // are tolerated there; the processor's listener is checked in full.
+    // Returns the worst block time as a share of its duration.
+    template <typename SampleType>
+    double exerciseProcessor(const BenchmarkCase& benchmarkCase, int numBlocks,
+                             const std::vector<std::pair<juce::String, juce::Array<float>>>& switches)
+    {
+        using Clock = std::chrono::steady_clock;
+
+        VinylAudioProcessor processor;
+
+        if constexpr (std::is_same_v<SampleType, double>)
+            processor.setProcessingPrecision(juce::AudioProcessor::doublePrecision);
+
+        if (! prepareProcessor(processor, benchmarkCase))
+            return 0.0;
+
+        const auto blockSize = benchmarkCase.blockSize;
+        const auto numChannels = benchmarkCase.numChannels;
+
+        juce::AudioBuffer<SampleType> buffer(numChannels, blockSize);
+        juce::MidiBuffer midi;
+        juce::Random random(1);
+        double worstSeconds = 0.0;
+
+        auto applySwitches = [&](int step)
+        {
+            for (auto& [id, values] : switches)
+            {
+                auto* parameter = processor.getParameters().getParameter(id);
+                const auto value = parameter->convertTo0to1(values[step % values.size()]);
+
+                if (juce::approximatelyEqual(parameter->getValue(), value))
+                    continue;
+
+                parameter->setValue(value);
+                parameter->sendValueChangedMessageToListeners(value);
+            }
+        };
+
+        // Once through every listener off the audio thread first: JUCE's
+        // listener lists allocate their iteration state on first use
+        applySwitches(1);
+        applySwitches(0);
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            if (block % 10 == 0)
+            {
+                RealtimeChecks::ScopedAudioThread audioThread;
+                RealtimeChecks::ScopedLocksTolerated hostLocks;
+                applySwitches(block / 10);
+            }
+
+            const auto silent = (block / 50) % 2 == 1;
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                for (int i = 0; i < blockSize; ++i)
+                    buffer.setSample(channel, i, silent ? SampleType() : (SampleType) (random.nextFloat() - 0.5f));
+
+            const auto start = Clock::now();
+            processor.processBlock(buffer, midi);
+            const auto elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+            worstSeconds = juce::jmax(worstSeconds, elapsed);
+            realtimeBlockTimes.add(elapsed * benchmarkCase.sampleRate / blockSize);
+
+            drainAnalysisFeed(processor.getAnalysisFeed());
+        }
+
+        processor.releaseResources();
+        return worstSeconds * benchmarkCase.sampleRate / blockSize;
+    }
+
+    // Sets the volume and EQ parameters to random values as fast as it can,
+    // from its own thread, as an editor or a host's automation thread would
+    class ParameterWriter : public juce::Thread
+    {
+    public:
+        explicit ParameterWriter(VinylAudioProcessor& processorToWrite)
+            : juce::Thread("Vinyl parameter writer"), processor(processorToWrite)
+        {
+        }
+
+        void run() override
+        {
+            const char* const ids[] { "VOLUME", "FIRST_EQ", "LOW_CUT", "HIGH_CUT" };
+            juce::Random random(2);
+
+            while (! threadShouldExit())
+            {
+                auto* parameter = processor.getParameters().getParameter(ids[random.nextInt((int) std::size(ids))]);
+                parameter->setValueNotifyingHost(random.nextFloat());
+                numWrites.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        std::atomic<juce::int64> numWrites { 0 };
+
+    private:
+        VinylAudioProcessor& processor;
+    };
+
+    struct StressResult
+    {
+        juce::int64 numWrites = 0;
+        bool bounded = true;            // Every sample finite and within range while writing
+        double settledDifference = 0.0; // Against the reference, once settled
+    };
+
+    // Runs a second of noise through the EQ and volume while a ParameterWriter
+    // hammers them, then sets final values and runs another second alongside
+    // a reference prepared with those values. A torn coefficient set shows as
+    // a runaway sample, or as output that doesn't settle onto the reference's.
+    StressResult stressParameters(const BenchmarkCase& benchmarkCase)
+    {
+        const std::vector<std::pair<juce::String, float>> finalValues { { "VOLUME", 0.8f },
+                                                                        { "FIRST_EQ", 0.6f },
+                                                                        { "LOW_CUT", 0.3f },
+                                                                        { "HIGH_CUT", 0.4f } };
+
+        VinylAudioProcessor processor, reference;
+        auto referenceCase = benchmarkCase;
+        referenceCase.setting.parameters.insert(referenceCase.setting.parameters.end(), finalValues.begin(), finalValues.end());
+
+        if (! prepareProcessor(processor, benchmarkCase) || ! prepareProcessor(reference, referenceCase))
+            return {};
+
+        const auto blockSize = benchmarkCase.blockSize;
+        const auto numChannels = benchmarkCase.numChannels;
+        const auto blocksPerSecond = juce::jmax(1, juce::roundToInt(benchmarkCase.sampleRate / blockSize));
+
+        juce::AudioBuffer<float> buffer(numChannels, blockSize), referenceBuffer(numChannels, blockSize);
+        juce::MidiBuffer midi;
+        juce::Random random(1);
+        StressResult result;
+
+        auto fillNoise = [&]
+        {
+            for (int channel = 0; channel < numChannels; ++channel)
+                for (int i = 0; i < blockSize; ++i)
+                    buffer.setSample(channel, i, random.nextFloat() - 0.5f);
+        };
+
+        {
+            ParameterWriter writer(processor);
+            writer.startThread();
+
+            for (int block = 0; block < blocksPerSecond; ++block)
+            {
+                fillNoise();
+                processor.processBlock(buffer, midi);
+
+                for (int channel = 0; channel < numChannels; ++channel)
+                {
+                    for (int i = 0; i < blockSize; ++i)
+                    {
+                        const auto sample = buffer.getSample(channel, i);
+                        result.bounded = result.bounded && std::isfinite(sample) && std::abs(sample) < 4.0f;
+                    }
+                }
+            }
+
+            writer.stopThread(-1);
+            result.numWrites = writer.numWrites.load();
+        }
+
+        for (auto& [id, value] : finalValues)
+        {
+            auto* parameter = processor.getParameters().getParameter(id);
+            parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+        }
+
+        for (int block = 0; block < blocksPerSecond; ++block)
+        {
+            fillNoise();
+            referenceBuffer.makeCopyOf(buffer, true);
+
+            processor.processBlock(buffer, midi);
+            reference.processBlock(referenceBuffer, midi);
+        }
+
+        result.settledDifference = getMaxDifference(buffer, referenceBuffer);
+
+        processor.releaseResources();
+        reference.releaseResources();
+        return result;
+    }
+
+    juce::var runRealtimeSuite(const Options& options)
+    {
+        constexpr int numBlocks = 300;
+        constexpr int maxDescribedPerCase = 4;
+
+        if (! RealtimeChecks::enabled)
+        {
+            std::cout << "skipped: build with -DVINYL_RT_CHECKS=ON" << std::endl;
+            return {};
+        }
+
+        const auto& heavyCrackle = VinylAudioProcessor::cracklePresets.back();
+
+        const std::vector<std::pair<juce::String, float>> everything { { "FIRST_EQ", 0.5f },
+                                                                       { "LOW_CUT", 0.5f },
+                                                                       { "HIGH_CUT", 0.5f },
+                                                                       { "CRACKLE_DENSITY", heavyCrackle.density },
+                                                                       { "CRACKLE_LEVEL", heavyCrackle.level },
+                                                                       { "SATURATION", 0.5f },
+                                                                       { "OVERSAMPLING", 2.0f },
+                                                                       { "OVERSAMPLING_FILTER", 1.0f },
+                                                                       { "WOBBLE", 0.5f },
+                                                                       { "WOBBLE_LINK", 0.0f } };
+
+        std::vector<Setting> settings { { "everything", everything } };
+        settings.push_back({ "everything, linear phase EQ", everything });
+        settings.back().parameters.push_back({ "LINEAR_PHASE_EQ", 1.0f });
+
+        for (int oversampling = 0; oversampling < 3; ++oversampling)
+            settings.push_back({ "saturation " + getOversamplingName(oversampling, 0),
+                                 { { "SATURATION", 0.5f }, { "OVERSAMPLING", (float) oversampling } } });
+
+        // Every choice, and the continuous parameters, changing while it plays
+        const std::vector<std::pair<juce::String, juce::Array<float>>> noSwitches, switches
+        {
+            { "EQ_MODE",             { 0.0f, 1.0f, 2.0f, 3.0f } },
+            { "FIRST_EQ",            { 0.0f, 0.7f, 0.3f } },
+            { "LINEAR_PHASE_EQ",     { 0.0f, 1.0f } },
+            { "OVERSAMPLING",        { 0.0f, 1.0f, 2.0f } },
+            { "OVERSAMPLING_FILTER", { 0.0f, 1.0f } },
+            { "WOBBLE",              { 0.0f, 0.5f } },
+            { "WOBBLE_LINK",         { 1.0f, 0.0f } },
+            { "VOLUME",              { 0.5f, 1.0f } }
+        };
+
+        std::cout << juce::String("setting").paddedRight(' ', 30) << "precision  block    rate  ch"
+                     "  violations   worst %" << std::endl;
+
+        juce::Array<juce::var> results;
+        auto failed = false;
+
+        for (auto isDouble : { false, true })
+        {
+            for (size_t i = 0; i <= settings.size(); ++i)
+            {
+                // The last pass starts from everything on and switches parameters
+                const auto isSwitching = i == settings.size();
+                const auto& setting = isSwitching ? settings.front() : settings[i];
+                const auto name = isSwitching ? juce::String("everything, switching") : setting.name;
+                const auto& caseSwitches = isSwitching ? switches : noSwitches;
+
+                for (auto numChannels : options.channelCounts)
+                {
+                    for (auto sampleRate : options.sampleRates)
+                    {
+                        for (auto blockSize : options.blockSizes)
+                        {
+                            const BenchmarkCase benchmarkCase { setting, blockSize, sampleRate, numChannels, true };
+                            const auto first = RealtimeChecks::getNumViolations();
+                            const auto worst = isDouble ? exerciseProcessor<double>(benchmarkCase, numBlocks, caseSwitches)
+                                                        : exerciseProcessor<float>(benchmarkCase, numBlocks, caseSwitches);
+                            const auto numViolations = RealtimeChecks::getNumViolations() - first;
+
+                            std::cout << name.paddedRight(' ', 30)
+                                      << juce::String(isDouble ? "double" : "float").paddedRight(' ', 9)
+                                      << juce::String(blockSize).paddedLeft(' ', 6)
+                                      << juce::String(sampleRate, 0).paddedLeft(' ', 8)
+                                      << juce::String(numChannels).paddedLeft(' ', 4)
+                                      << juce::String(numViolations).paddedLeft(' ', 12)
+                                      << juce::String(worst * 100.0, 2).paddedLeft(' ', 10) << std::endl;
+
+                            for (int v = first; v < first + juce::jmin(maxDescribedPerCase, numViolations); ++v)
+                            {
+                                RealtimeChecks::Violation violation;
+
+                                if (RealtimeChecks::getViolation(v, violation))
+                                    std::cout << RealtimeChecks::describe(violation) << std::endl;
+                            }
+
+                            failed = failed || numViolations > 0;
+
+                            auto* object = new juce::DynamicObject();
+                            object->setProperty("setting", name);
+                            object->setProperty("precision", isDouble ? "double" : "float");
+                            object->setProperty("blockSize", blockSize);
+                            object->setProperty("sampleRate", sampleRate);
+                            object->setProperty("channels", numChannels);
+                            object->setProperty("violations", numViolations);
+                            object->setProperty("worstBudgetPercent", worst * 100.0);
+                            results.add(juce::var(object));
+                        }
+                    }
+                }
+            }
+        }
+
+        // Parameters written from another thread while blocks run
+        constexpr double maxSettledDifference = 1.0e-5;
+        const Setting eqOnly { "EQ, concurrent writes", { { "CRACKLE_DENSITY", 0.0f }, { "CRACKLE_LEVEL", 0.0f } } };
+        auto torn = false;
+
+        std::cout << std::endl << juce::String("setting").paddedRight(' ', 30) << "block    rate  ch  violations"
+                     "      writes  bounded  settled diff" << std::endl;
+
+        for (auto numChannels : options.channelCounts)
+        {
+            for (auto sampleRate : options.sampleRates)
+            {
+                for (auto blockSize : options.blockSizes)
+                {
+                    const BenchmarkCase benchmarkCase { eqOnly, blockSize, sampleRate, numChannels, false };
+                    const auto first = RealtimeChecks::getNumViolations();
+                    const auto stress = stressParameters(benchmarkCase);
+                    const auto numViolations = RealtimeChecks::getNumViolations() - first;
+
+                    std::cout << eqOnly.name.paddedRight(' ', 30)
+                              << juce::String(blockSize).paddedLeft(' ', 5)
+                              << juce::String(sampleRate, 0).paddedLeft(' ', 8)
+                              << juce::String(numChannels).paddedLeft(' ', 4)
+                              << juce::String(numViolations).paddedLeft(' ', 12)
+                              << juce::String(stress.numWrites).paddedLeft(' ', 12)
+                              << juce::String(stress.bounded ? "yes" : "NO").paddedLeft(' ', 9)
+                              << juce::String(stress.settledDifference, 8).paddedLeft(' ', 14) << std::endl;
+
+                    for (int v = first; v < first + juce::jmin(maxDescribedPerCase, numViolations); ++v)
+                    {
+                        RealtimeChecks::Violation violation;
+
+                        if (RealtimeChecks::getViolation(v, violation))
+                            std::cout << RealtimeChecks::describe(violation) << std::endl;
+                    }
+
+                    failed = failed || numViolations > 0;
+                    torn = torn || ! stress.bounded || ! (stress.settledDifference < maxSettledDifference);
+
+                    auto* object = new juce::DynamicObject();
+                    object->setProperty("setting", eqOnly.name);
+                    object->setProperty("blockSize", blockSize);
+                    object->setProperty("sampleRate", sampleRate);
+                    object->setProperty("channels", numChannels);
+                    object->setProperty("violations", numViolations);
+                    object->setProperty("writes", stress.numWrites);
+                    object->setProperty("bounded", stress.bounded);
+                    object->setProperty("settledDifference", stress.settledDifference);
+                    results.add(juce::var(object));
+                }
+            }
+        }
+
+        std::cout << (failed ? "FAILED: the audio thread allocated, freed or locked"
+                             : "passed: no allocations, frees or locks on the audio thread") << std::endl
+                  << (torn ? "FAILED: the output ran away or didn't settle on the written values"
+                           : "passed: no torn coefficient sets under concurrent writes") << std::endl;
+
+        checksFailed = checksFailed || failed || torn;
+        return results;
+    }
+
+    //==============================================================================
+    // Renders input through a freshly prepared processor in blocks of
+    // blockSize, the way an offline host would, and returns the output
+    template <typename SampleType>
+    juce::AudioBuffer<SampleType> renderOffline(const Setting& setting, double sampleRate,
+                                                const juce::AudioBuffer<SampleType>& input, int blockSize)
+    {
+        const auto numChannels = input.getNumChannels();
+        const auto numSamples = input.getNumSamples();
+
+        juce::AudioBuffer<SampleType> output;
+        output.makeCopyOf(input);
+
+        VinylAudioProcessor processor;
+        processor.setNonRealtime(true);
+
+        if constexpr (std::is_same_v<SampleType, double>)
+            processor.setProcessingPrecision(juce::AudioProcessor::doublePrecision);
+
+        if (! prepareProcessor(processor, { setting, blockSize, sampleRate, numChannels }))
+            return {};
+
+        juce::MidiBuffer midi;
+
+        for (int position = 0; position < numSamples; position += blockSize)
+        {
+            juce::AudioBuffer<SampleType> block(output.getArrayOfWritePointers(), numChannels, position,
+                                                juce::jmin(blockSize, numSamples - position));
+            processor.processBlock(block, midi);
+        }
+
+        processor.releaseResources();
+        return output;
+    }
+
+    // The response the EQ is designed to have for these control values
+    // (Vinyl EQ, Low Cut, High Cut): its sections designed directly, in double
+    double getIntendedMagnitude(const std::array<float, 3>& values, double frequency, double sampleRate)
+    {
+        using EQ = VinylEQ<double>;
+
+        std::array<BiquadCoefficients<double>, EQ::numControls * EQ::maxSectionsPerControl> sections;
+        int numSections = 0;
+
+        for (int i = 0; i < EQ::numControls; ++i)
+        {
+            if (values[(size_t) i] <= 0.0f)
+                continue;
+
+            EQ::design((EQ::Control) i, sampleRate, values[(size_t) i], sections.data() + numSections);
+            numSections += EQ::getNumSections((EQ::Control) i);
+        }
+
+        return BiquadDesign::getMagnitude(sections.data(), numSections, frequency, sampleRate);
+    }
+
+    // Magnitude of the DFT of a channel at one frequency
+    template <typename SampleType>
+    double getMeasuredMagnitude(const juce::AudioBuffer<SampleType>& response, double frequency, double sampleRate)
+    {
+        const auto step = std::polar(1.0, -juce::MathConstants<double>::twoPi * frequency / sampleRate);
+        auto phasor = std::complex<double>(1.0);
+        std::complex<double> sum;
+
+        for (int i = 0; i < response.getNumSamples(); ++i)
+        {
+            sum += (double) response.getSample(0, i) * phasor;
+            phasor *= step;
+        }
+
+        return std::abs(sum);
+    }
+
+    // Measures the processor's response to an impulse with only the EQ on, and
+    // compares it with the designed curves between minFrequency and 20 kHz
+    // (or 0.45 of the sample rate) at sixth-octave steps. Returns the worst
+    // difference in dB and prints the response at the three Vinyl EQ corners.
+    template <typename SampleType>
+    double checkEQResponse(const std::array<float, 3>& values, bool linearPhase, double sampleRate,
+                           double minFrequency, juce::String& corners)
+    {
+        constexpr SampleType impulseLevel = (SampleType) 0.5;
+
+        const Setting setting { "eq", { { "VOLUME", 1.0f },
+                                        { "FIRST_EQ", values[0] },
+                                        { "LOW_CUT", values[1] },
+                                        { "HIGH_CUT", values[2] },
+                                        { "LINEAR_PHASE_EQ", linearPhase ? 1.0f : 0.0f },
+                                        { "CRACKLE_DENSITY", 0.0f },
+                                        { "SATURATION", 0.0f },
+                                        { "WOBBLE", 0.0f } } };
+
+        juce::AudioBuffer<SampleType> impulse(1, (int) sampleRate);
+        impulse.clear();
+        impulse.setSample(0, 0, impulseLevel);
+
+        const auto response = renderOffline(setting, sampleRate, impulse, 512);
+        const auto maxFrequency = juce::jmin(20000.0, sampleRate * 0.45);
+        auto worst = 0.0;
+
+        for (auto frequency = minFrequency; frequency <= maxFrequency; frequency *= std::exp2(1.0 / 6.0))
+        {
+            const auto measured = getMeasuredMagnitude(response, frequency, sampleRate) / impulseLevel;
+            const auto intended = getIntendedMagnitude(values, frequency, sampleRate);
+            worst = juce::jmax(worst, std::abs(juce::Decibels::gainToDecibels(measured / intended, -200.0)));
+        }
+
+        for (auto frequency : { 80.0, 325.0, 10000.0 })
+        {
+            const auto measured = getMeasuredMagnitude(response, frequency, sampleRate) / impulseLevel;
+            corners << juce::String(juce::Decibels::gainToDecibels(measured, -200.0), 2).paddedLeft(' ', 9);
+        }
+
+        return worst;
+    }
+
+    juce::var runGoldenSuite(const Options& options)
+    {
+        constexpr int blockSize = 512;
+        constexpr double seconds = 0.5;
+
+        const Setting bypass { "bypass", { { "VOLUME", 1.0f },
+                                           { "CRACKLE_DENSITY", 0.0f } } };
+        const auto& mediumCrackle = VinylAudioProcessor::cracklePresets[2];
+
+        std::vector<Setting> settings { bypass, bypass, bypass, bypass, bypass };
+        settings[1].name = "vinyl eq";
+        settings[1].parameters.push_back({ "FIRST_EQ", 0.5f });
+        settings[2].name = "low cut + high cut";
+        settings[2].parameters.insert(settings[2].parameters.end(), { { "LOW_CUT", 0.5f }, { "HIGH_CUT", 0.5f } });
+        settings[3].name = "linear phase eq";
+        settings[3].parameters.insert(settings[3].parameters.end(), { { "FIRST_EQ", 0.5f }, { "LINEAR_PHASE_EQ", 1.0f } });
+        settings[4].name = "full chain";
+        settings[4].parameters = { { "VOLUME", 0.8f },
+                                   { "FIRST_EQ", 0.5f },
+                                   { "CRACKLE_DENSITY", mediumCrackle.density },
+                                   { "CRACKLE_LEVEL", mediumCrackle.level },
+                                   { "SATURATION", 0.5f },
+                                   { "WOBBLE", 0.5f } };
+
+        juce::Array<juce::var> results;
+
+        //==============================================================================
+        // Fixed signals through each setting, against the stored references
+        const auto toleranceGain = juce::Decibels::decibelsToGain(options.goldenToleranceDecibels, -400.0);
+
+        juce::AudioFormatManager formats;
+        formats.registerBasicFormats();
+        juce::WavAudioFormat wav;
+
+        if (options.goldenDirectory == juce::File())
+            std::cout << "no --golden directory: only checking that renders repeat exactly" << std::endl;
+        else if (options.updateGolden && options.goldenDirectory.createDirectory().failed())
+            std::cout << "can't create " << options.goldenDirectory.getFullPathName() << std::endl;
+
+        std::cout << "signal   setting                 rate  precision   repeats   reference dB   bit-exact" << std::endl;
+
+        for (auto sampleRate : { 44100.0, 96000.0 })
+        {
+            const auto numSamples = (int) (seconds * sampleRate);
+            const auto sweepRate = std::log(1000.0) / seconds;
+
+            // An impulse, a 20 Hz - 20 kHz exponential sweep and white noise, at -6 dB
+            std::array<std::pair<juce::String, juce::AudioBuffer<double>>, 3> signals;
+            signals[0].first = "impulse";
+            signals[1].first = "sweep";
+            signals[2].first = "noise";
+
+            juce::Random random(1);
+
+            for (auto& signal : signals)
+            {
+                signal.second.setSize(2, numSamples);
+                signal.second.clear();
+            }
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                const auto time = i / sampleRate;
+                const auto sweep = 0.5 * std::sin(juce::MathConstants<double>::twoPi * 20.0 * (std::exp(sweepRate * time) - 1.0) / sweepRate);
+
+                for (int channel = 0; channel < 2; ++channel)
+                {
+                    signals[1].second.setSample(channel, i, sweep);
+                    signals[2].second.setSample(channel, i, random.nextDouble() - 0.5);
+                }
+            }
+
+            signals[0].second.setSample(0, 0, 0.5);
+            signals[0].second.setSample(1, 0, 0.5);
+
+            for (auto& [signalName, signal] : signals)
+            {
+                for (auto& setting : settings)
+                {
+                    for (auto isDouble : { false, true })
+                    {
+                        // Both precisions are stored as 32-bit float; a double
+                        // render can only match within the tolerance
+                        juce::AudioBuffer<float> output;
+                        auto repeats = true;
+
+                        if (isDouble)
+                        {
+                            const auto first = renderOffline(setting, sampleRate, signal, blockSize);
+                            repeats = getMaxDifference(first, renderOffline(setting, sampleRate, signal, blockSize)) == 0.0;
+                            output.makeCopyOf(first);
+                        }
+                        else
+                        {
+                            juce::AudioBuffer<float> input;
+                            input.makeCopyOf(signal);
+
+                            output = renderOffline(setting, sampleRate, input, blockSize);
+                            repeats = getMaxDifference(output, renderOffline(setting, sampleRate, input, blockSize)) == 0.0;
+                        }
+
+                        const auto fileName = signalName + "_" + setting.name.removeCharacters(" +") + "_" + juce::String((int) sampleRate) + "_" + (isDouble ? "double" : "float") + ".wav";
+                        auto referenceDecibels = std::numeric_limits<double>::quiet_NaN();
+                        auto bitExact = false;
+                        auto passed = repeats;
+
+                        if (options.goldenDirectory != juce::File())
+                        {
+                            const auto file = options.goldenDirectory.getChildFile(fileName);
+
+                            if (options.updateGolden)
+                            {
+                                file.deleteFile();
+                                std::unique_ptr<juce::AudioFormatWriter> writer;
+
+                                if (auto stream = file.createOutputStream())
+                                {
+                                    writer.reset(wav.createWriterFor(stream.get(), sampleRate, (unsigned int) output.getNumChannels(), 32, {}, 0));
+
+                                    if (writer != nullptr)
+                                        stream.release();   // Now owned by the writer
+                                }
+
+                                passed = passed && writer != nullptr && writer->writeFromAudioSampleBuffer(output, 0, numSamples);
+                            }
+                            else if (std::unique_ptr<juce::AudioFormatReader> reader { formats.createReaderFor(file) })
+                            {
+                                juce::AudioBuffer<float> reference((int) reader->numChannels, (int) reader->lengthInSamples);
+                                reader->read(&reference, 0, reference.getNumSamples(), 0, true, true);
+
+                                const auto difference = getMaxDifference(output, reference);
+                                referenceDecibels = juce::Decibels::gainToDecibels(difference, -200.0);
+                                bitExact = difference == 0.0;
+                                passed = passed && difference <= toleranceGain;
+                            }
+                            else
+                            {
+                                std::cout << "no reference " << file.getFullPathName() << std::endl;
+                                passed = false;
+                            }
+                        }
+
+                        checksFailed = checksFailed || ! passed;
+
+                        std::cout << signalName.paddedRight(' ', 9)
+                                  << setting.name.paddedRight(' ', 20)
+                                  << juce::String(sampleRate, 0).paddedLeft(' ', 8)
+                                  << juce::String(isDouble ? "double" : "float").paddedLeft(' ', 11)
+                                  << juce::String(repeats ? "yes" : "NO").paddedLeft(' ', 10)
+                                  << (std::isnan(referenceDecibels) ? juce::String("-") : juce::String(referenceDecibels, 1)).paddedLeft(' ', 15)
+                                  << juce::String(bitExact ? "yes" : "no").paddedLeft(' ', 12)
+                                  << (passed ? "" : "   FAILED") << std::endl;
+
+                        auto* object = new juce::DynamicObject();
+                        object->setProperty("signal", signalName);
+                        object->setProperty("setting", setting.name);
+                        object->setProperty("sampleRate", sampleRate);
+                        object->setProperty("precision", isDouble ? "double" : "float");
+                        object->setProperty("repeats", repeats);
+                        object->setProperty("referenceDifferenceDecibels", std::isnan(referenceDecibels) ? juce::var() : juce::var(referenceDecibels));
+                        object->setProperty("bitExact", bitExact);
+                        object->setProperty("passed", passed);
+                        results.add(juce::var(object));
+                    }
+                }
+            }
+        }
+
+        //==============================================================================
+        // The EQ's measured response against the curves it is designed to have:
+        // the 80 Hz high-pass, the 325 Hz peak and the 10 kHz roll-off of the
+        // Vinyl EQ, and the two cuts. Linear phase only from 80 Hz, where its
+        // kernel resolves the high-passes.
+        struct ResponseCase
+        {
+            juce::String name;
+            std::array<float, 3> values;
+            bool linearPhase;
+            double minFrequency, toleranceDecibels;
+        };
+
+        const ResponseCase responseCases[]
+        {
+            { "vinyl eq 0.25",           { 0.25f, 0.0f, 0.0f }, false, 20.0, 0.1 },
+            { "vinyl eq 1",              { 1.0f, 0.0f, 0.0f },  false, 20.0, 0.1 },
+            { "low cut 0.5",             { 0.0f, 0.5f, 0.0f },  false, 20.0, 0.1 },
+            { "high cut 0.5",            { 0.0f, 0.0f, 0.5f },  false, 20.0, 0.1 },
+            { "all 0.7",                 { 0.7f, 0.7f, 0.7f },  false, 20.0, 0.1 },
+            { "vinyl eq 1, linear phase", { 1.0f, 0.0f, 0.0f }, true,  80.0, 0.25 }
+        };
+
+        std::cout << std::endl << "response                     rate  precision   worst dB    80 Hz   325 Hz    10 kHz" << std::endl;
+
+        for (auto& responseCase : responseCases)
+        {
+            for (auto sampleRate : options.sampleRates)
+            {
+                for (auto isDouble : { false, true })
+                {
+                    juce::String corners;
+                    const auto worst = isDouble ? checkEQResponse<double>(responseCase.values, responseCase.linearPhase, sampleRate, responseCase.minFrequency, corners)
+                                                : checkEQResponse<float>(responseCase.values, responseCase.linearPhase, sampleRate, responseCase.minFrequency, corners);
+                    const auto passed = worst <= responseCase.toleranceDecibels;
+                    checksFailed = checksFailed || ! passed;
+
+                    std::cout << responseCase.name.paddedRight(' ', 25)
+                              << juce::String(sampleRate, 0).paddedLeft(' ', 8)
+                              << juce::String(isDouble ? "double" : "float").paddedLeft(' ', 11)
+                              << juce::String(worst, 3).paddedLeft(' ', 11)
+                              << corners << (passed ? "" : "   FAILED") << std::endl;
+
+                    auto* object = new juce::DynamicObject();
+                    object->setProperty("response", responseCase.name);
+                    object->setProperty("sampleRate", sampleRate);
+                    object->setProperty("precision", isDouble ? "double" : "float");
+                    object->setProperty("worstDifferenceDecibels", worst);
+                    object->setProperty("passed", passed);
+                    results.add(juce::var(object));
+                }
+            }
+        }
+
+        return results;
+    }
+
+    //==============================================================================
+    // A way a host may split the stream into processBlock calls
+    struct HostPattern
+    {
+        const char* name;
+        std::vector<int> sizes;     // Cycled through; empty draws each size between 1 and 1024
+    };
+
+    // Renders input in calls of the pattern's sizes through a processor
+    // prepared for preparedSize, timing every call. The worst budget is the
+    // slowest call against the audio it covers.
+    template <typename SampleType>
+    juce::AudioBuffer<SampleType> renderInCalls(const BenchmarkCase& benchmarkCase, const HostPattern& pattern,
+                                                const juce::AudioBuffer<SampleType>& input, BenchmarkResult& result)
+    {
+        using Clock = std::chrono::steady_clock;
+
+        const auto numChannels = input.getNumChannels();
+        const auto numSamples = input.getNumSamples();
+
+        juce::AudioBuffer<SampleType> output;
+        output.makeCopyOf(input);
+
+        result.benchmarkCase = benchmarkCase;
+
+        VinylAudioProcessor processor;
+
+        if constexpr (std::is_same_v<SampleType, double>)
+            processor.setProcessingPrecision(juce::AudioProcessor::doublePrecision);
+
+        if (! prepareProcessor(processor, benchmarkCase))
+            return {};
+
+        result.latencySamples = processor.getLatencySamples();
+
+        juce::MidiBuffer midi;
+        juce::Random random(1);
+        double totalSeconds = 0.0;
+        size_t call = 0;
+
+        for (int position = 0; position < numSamples; ++call)
+        {
+            const auto size = pattern.sizes.empty() ? random.nextInt({ 1, 1025 })
+                                                    : pattern.sizes[call % pattern.sizes.size()];
+            const auto length = juce::jmin(size, numSamples - position);
+
+            juce::AudioBuffer<SampleType> block(output.getArrayOfWritePointers(), numChannels, position, length);
+
+            const auto start = Clock::now();
+            processor.processBlock(block, midi);
+            const auto elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+            totalSeconds += elapsed;
+            result.worstBlockMicroseconds = juce::jmax(result.worstBlockMicroseconds, elapsed * 1.0e6);
+            result.worstBudgetPercent = juce::jmax(result.worstBudgetPercent, 100.0 * elapsed * benchmarkCase.sampleRate / length);
+            position += length;
+        }
+
+        processor.releaseResources();
+
+        result.nsPerSample = totalSeconds * 1.0e9 / numSamples;
+        result.meanBlockMicroseconds = totalSeconds * 1.0e6 / (double) call;
+        result.budgetPercent = 100.0 * totalSeconds * benchmarkCase.sampleRate / numSamples;
+        return output;
+    }
+
+    juce::var runHostPatternsSuite(const Options& options)
+    {
+        const auto& mediumCrackle = VinylAudioProcessor::cracklePresets[2];
+
+        const Setting setting { "full chain", { { "FIRST_EQ", 0.5f },
+                                                { "LOW_CUT", 0.5f },
+                                                { "HIGH_CUT", 0.5f },
+                                                { "CRACKLE_DENSITY", mediumCrackle.density },
+                                                { "CRACKLE_LEVEL", mediumCrackle.level },
+                                                { "SATURATION", 0.5f },
+                                                { "WOBBLE", 0.5f } } };
+
+        // The first is the reference the others are compared with
+        const HostPattern patterns[] {
+            { "512",          { 512 } },
+            { "64",           { 64 } },
+            { "1",            { 1 } },
+            { "37",           { 37 } },
+            { "333",          { 333 } },
+            { "random",       {} },
+            { "2048",         { 2048 } },
+            { "1, 1023",      { 1, 1023 } }
+        };
+
+        constexpr int preparedSize = 512;
+
+        std::cout << "rate     ch  precision  calls      ns/sample   budget %   worst %   difference dB" << std::endl;
+
+        juce::Array<juce::var> results;
+
+        auto runPatterns = [&](auto sampleType, double sampleRate, int numChannels)
+        {
+            using SampleType = decltype(sampleType);
+
+            const auto numSamples = (int) std::ceil(options.secondsPerCase * sampleRate);
+            juce::AudioBuffer<SampleType> input(numChannels, numSamples);
+            juce::Random random(1);
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                for (int i = 0; i < numSamples; ++i)
+                    input.setSample(channel, i, (SampleType) (random.nextFloat() - 0.5f));
+
+            juce::AudioBuffer<SampleType> reference;
+
+            for (auto& pattern : patterns)
+            {
+                BenchmarkResult result;
+                const auto output = renderInCalls<SampleType>({ setting, preparedSize, sampleRate, numChannels },
+                                                              pattern, input, result);
+
+                if (reference.getNumSamples() == 0)
+                    reference.makeCopyOf(output);
+
+                const auto difference = getMaxDifference(output, reference);
+
+                std::cout << juce::String(sampleRate, 0).paddedRight(' ', 9)
+                          << juce::String(numChannels).paddedLeft(' ', 2)
+                          << juce::String(std::is_same_v<SampleType, double> ? "double" : "float").paddedLeft(' ', 11)
+                          << "  " << juce::String(pattern.name).paddedRight(' ', 8)
+                          << juce::String(result.nsPerSample, 2).paddedLeft(' ', 12)
+                          << juce::String(result.budgetPercent, 3).paddedLeft(' ', 11)
+                          << juce::String(result.worstBudgetPercent, 2).paddedLeft(' ', 10)
+                          << (difference == 0.0 ? juce::String("exact") : juce::String(juce::Decibels::gainToDecibels(difference, -400.0), 1)).paddedLeft(' ', 16)
+                          << std::endl;
+
+                auto object = toVar(result);
+                object.getDynamicObject()->setProperty("pattern", pattern.name);
+                object.getDynamicObject()->setProperty("precision", std::is_same_v<SampleType, double> ? "double" : "float");
+                object.getDynamicObject()->setProperty("maxDifferenceDecibels", juce::Decibels::gainToDecibels(difference, -400.0));
+                results.add(object);
+            }
+        };
+
+        for (auto sampleRate : options.sampleRates)
+        {
+            for (auto numChannels : options.channelCounts)
+            {
+                runPatterns(float(), sampleRate, numChannels);
+                runPatterns(double(), sampleRate, numChannels);
+            }
+        }
+
+        return results;
+    }
+
+    //==============================================================================
+    struct EngineCase
+    {
+        const char* name;
+        int blockSize;
+        bool streaming;     // Walk through the whole render in the arena, instead of reusing one block
+        RenderEngine::Layout layout;
+        bool pinThreads;
+    };
+
+    juce::var runEngineSuite(const Options& options)
+    {
+        constexpr double sampleRate = 48000.0;
+        constexpr int numChannels = 2;
+
+        // The same work at every thread count: two instances per CPU
+        const auto numCpus = juce::SystemStats::getNumCpus();
+        const auto numInstances = 2 * numCpus;
+
+        const auto& mediumCrackle = VinylAudioProcessor::cracklePresets[2];
+
+        const Setting setting { "stem", { { "VOLUME", 0.8f },
+                                          { "FIRST_EQ", 0.5f },
+                                          { "LOW_CUT", 0.5f },
+                                          { "HIGH_CUT", 0.5f },
+                                          { "CRACKLE_DENSITY", mediumCrackle.density },
+                                          { "CRACKLE_LEVEL", mediumCrackle.level },
+                                          { "SATURATION", 0.5f },
+                                          { "WOBBLE", 0.5f } } };
+
+        // Blocks of 100 samples aren't a whole number of cache lines, so in
+        // the packed layout neighbouring instances share a line at each end
+        const EngineCase cases[] {
+            { "padded 512",     512, false, RenderEngine::Layout::padded, true },
+            { "padded 100",     100, false, RenderEngine::Layout::padded, true },
+            { "packed 100",     100, false, RenderEngine::Layout::packed, true },
+            { "streaming 512",  512, true,  RenderEngine::Layout::padded, true },
+            { "unpinned 512",   512, false, RenderEngine::Layout::padded, false }
+        };
+
+        juce::Array<int> threadCounts;
+
+        for (int threads = 1; threads < numCpus; threads *= 2)
+            threadCounts.add(threads);
+
+        threadCounts.add(numCpus);
+
+        const auto numSamples = juce::jmax(4096, (int) std::ceil(options.secondsPerCase * sampleRate));
+
+        juce::AudioBuffer<float> noise(numChannels, numSamples);
+        juce::Random random(1);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            for (int i = 0; i < numSamples; ++i)
+                noise.setSample(channel, i, random.nextFloat() - 0.5f);
+
+        std::cout << numInstances << " instances, " << juce::String(numSamples / sampleRate, 2) << " s each, "
+                  << numChannels << " channels at " << juce::String(sampleRate, 0) << " Hz, offline" << std::endl
+                  << "case            threads   x realtime   speedup   efficiency %   latency ms   worst ms   stolen %" << std::endl;
+
+        juce::Array<juce::var> results;
+
+        for (auto& engineCase : cases)
+        {
+            double singleThreadFactor = 0.0;
+            int limitedFrom = 0;
+
+            for (auto numThreads : threadCounts)
+            {
+                RenderEngine::Options engineOptions;
+                engineOptions.numThreads = numThreads;
+                engineOptions.pinThreads = engineCase.pinThreads;
+                engineOptions.layout = engineCase.layout;
+
+                RenderEngine engine(engineOptions);
+
+                for (int i = 0; i < numInstances; ++i)
+                {
+                    auto processor = std::make_unique<VinylAudioProcessor>();
+
+                    for (auto& [id, value] : setting.parameters)
+                        if (auto* parameter = processor->getParameters().getParameter(id))
+                            parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+
+                    processor->setRandomSeed((juce::uint32) i + 1);
+                    processor->setNonRealtime(true);
+                    engine.addInstance(std::move(processor));
+                }
+
+                const auto blockSize = engineCase.blockSize;
+                const auto bufferLength = engineCase.streaming ? numSamples : blockSize;
+
+                if (! engine.prepare(sampleRate, numChannels, blockSize, bufferLength))
+                    continue;
+
+                auto fill = [&](int start, int length)
+                {
+                    for (int i = 0; i < numInstances; ++i)
+                        for (int channel = 0; channel < numChannels; ++channel)
+                            engine.getBuffer(i).copyFrom(channel, engineCase.streaming ? start : 0, noise, channel, start, length);
+                };
+
+                // Streaming renders fill the arena up front; resident ones refill
+                // the block before each cycle, outside the engine's timing
+                if (engineCase.streaming)
+                    fill(0, numSamples);
+
+                constexpr int numWarmupBlocks = 8;
+
+                for (int position = 0, block = 0; position < numSamples; position += blockSize, ++block)
+                {
+                    const auto length = juce::jmin(blockSize, numSamples - position);
+
+                    if (! engineCase.streaming)
+                        fill(position, length);
+
+                    if (block == numWarmupBlocks)
+                        engine.resetStats();
+
+                    engine.process(engineCase.streaming ? position : 0, length);
+                }
+
+                const auto stats = engine.getStats();
+                engine.release();
+
+                const auto realtimeFactor = stats.getRealtimeFactor();
+
+                if (numThreads == 1)
+                    singleThreadFactor = realtimeFactor;
+
+                const auto speedup = realtimeFactor / juce::jmax(1.0e-9, singleThreadFactor);
+                const auto efficiency = 100.0 * speedup / numThreads;
+                const auto stolenPercent = 100.0 * (double) stats.numStolenJobs / (double) juce::jmax((juce::int64) 1, stats.numJobs);
+
+                if (limitedFrom == 0 && efficiency < 80.0)
+                    limitedFrom = numThreads;
+
+                std::cout << juce::String(engineCase.name).paddedRight(' ', 15)
+                          << juce::String(numThreads).paddedLeft(' ', 8)
+                          << juce::String(realtimeFactor, 1).paddedLeft(' ', 13)
+                          << juce::String(speedup, 2).paddedLeft(' ', 10)
+                          << juce::String(efficiency, 1).paddedLeft(' ', 15)
+                          << juce::String(stats.meanJobLatencySeconds * 1.0e3, 3).paddedLeft(' ', 13)
+                          << juce::String(stats.worstJobLatencySeconds * 1.0e3, 3).paddedLeft(' ', 11)
+                          << juce::String(stolenPercent, 1).paddedLeft(' ', 11) << std::endl;
+
+                auto* object = new juce::DynamicObject();
+                object->setProperty("case", engineCase.name);
+                object->setProperty("threads", numThreads);
+                object->setProperty("instances", numInstances);
+                object->setProperty("realtimeFactor", realtimeFactor);
+                object->setProperty("speedup", speedup);
+                object->setProperty("efficiencyPercent", efficiency);
+                object->setProperty("meanJobLatencyMs", stats.meanJobLatencySeconds * 1.0e3);
+                object->setProperty("worstJobLatencyMs", stats.worstJobLatencySeconds * 1.0e3);
+                object->setProperty("worstCycleMs", stats.worstCycleSeconds * 1.0e3);
+                object->setProperty("stolenPercent", stolenPercent);
+                results.add(juce::var(object));
+            }
+
+            // Where adding threads stops paying for itself: shared memory
+            // bandwidth for the streaming case, shared lines for the packed one
+            std::cout << juce::String(engineCase.name).paddedRight(' ', 15) << "   "
+                      << (limitedFrom > 0 ? "below 80% efficiency from " + juce::String(limitedFrom) + " threads"
+                                          : juce::String("80% efficiency or better up to every CPU")) << std::endl;
+        }
+
+        return results;
+    }
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args(argc, argv);
+
+    Options options;
+
+    for (int i = 0; i + 1 < args.size(); ++i)
+    {
+        const auto& arg = args[i];
+
+        if (arg == "--suites")
+            options.suites = juce::StringArray::fromTokens(args[++i].text, ",", "");
+        else if (arg == "--block-sizes")
+            options.blockSizes = parseList<int>(args[++i].text);
+        else if (arg == "--rates")
+            options.sampleRates = parseList<double>(args[++i].text);
+        else if (arg == "--channels")
+            options.channelCounts = parseList<int>(args[++i].text);
+        else if (arg == "--seconds")
+            options.secondsPerCase = juce::jmax(0.01, args[++i].text.getDoubleValue());
+        else if (arg == "--instances")
+            options.numInstances = juce::jmax(1, args[++i].text.getIntValue());
+        else if (arg == "--json")
+            options.jsonFile = args[++i].resolveAsFile();
+        else if (arg == "--label")
+            options.label = args[++i].text;
+        else if (arg == "--rt-report")
+            options.rtReportFile = args[++i].resolveAsFile();
+        else if (arg == "--golden")
+            options.goldenDirectory = args[++i].resolveAsFile();
+        else if (arg == "--golden-tolerance")
+            options.goldenToleranceDecibels = args[++i].text.getDoubleValue();
+    }
+
+    options.updateGolden = args.containsOption("--update-golden");
+
+    const std::pair<const char*, juce::var (*)(const Options&)> suites[] =
+    {
+        { "processBlock",  runProcessBlockSuite },
+        { "aliasing",      runAliasingSuite },
+        { "interpolation", runInterpolationSuite },
+        { "load",          runLoadSuite },
+        { "idle",          runIdleSuite },
+        { "automation",    runAutomationSuite },
+        { "eqTables",      runEQTablesSuite },
+        { "memory",        runMemorySuite },
+        { "channels",      runChannelsSuite },
+        { "cascade",       runCascadeSuite },
+        { "gain",          runGainSuite },
+        { "precision",     runPrecisionSuite },
+        { "metering",      runMeteringSuite },
+        { "linearPhase",   runLinearPhaseSuite },
+        { "quality",       runQualitySuite },
+        { "realtime",      runRealtimeSuite },
+        { "golden",        runGoldenSuite },
+        { "hostPatterns",  runHostPatternsSuite },
+        { "engine",        runEngineSuite }
+    };
+
+    auto* report = new juce::DynamicObject();
+    const juce::var reportVar(report);
+
+    report->setProperty("label", options.label);
+    report->setProperty("date", juce::Time::getCurrentTime().toISO8601(true));
+    report->setProperty("cpu", juce::SystemStats::getCpuModel());
+
+    for (auto& [name, run] : suites)
+    {
+        if (! options.suites.isEmpty() && ! options.suites.contains(name))
+            continue;
+
+        std::cout << std::endl << "== " << name << std::endl;
+        report->setProperty(name, run(options));
+    }
+
+    if (options.jsonFile != juce::File())
+    {
+        if (! options.jsonFile.replaceWithText(juce::JSON::toString(reportVar)))
+        {
+            std::cerr << "Can't write " << options.jsonFile.getFullPathName() << std::endl;
+            return 1;
+        }
+    }
+
+    if (options.rtReportFile != juce::File())
+    {
+        if (! RealtimeChecks::writeReport(options.rtReportFile, realtimeBlockTimes))
+        {
+            std::cerr << "Can't write " << options.rtReportFile.getFullPathName() << std::endl;
+            return 1;
+        }
+    }
+
+    return checksFailed ? 1 : 0;
+}
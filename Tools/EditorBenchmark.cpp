@@ -0,0 +1,367 @@
+/*
+    Editor CPU benchmark.
+
+    Usage:
+        VinylEditorBenchmark [--editors <n>] [--seconds <s>] [--json <file>]
+
+    Opens --editors editor windows (20 by default), each on its own processor.
+    A simulated audio thread feeds every processor noise in real time, so the
+    meters and spectra move as they would in a session. The message thread's
+    CPU time over --seconds (10 by default) is what the editors cost; it is
+    measured with the knobs and sliders buffered to images and without.
+
+    It also times painting one editor offscreen: a full repaint, as after a
+    resize or when the host invalidates the window, and a repaint of only the
+    meter and spectrum, which is what the editor's timer causes. These need
+    no display; without one, the windows are skipped. Thread CPU time is
+    only read on Linux and macOS.
+*/
+
+#include <JuceHeader.h>
+#include <chrono>
+#include <iostream>
+#include "../PluginEditor.h"
+
+#if JUCE_LINUX || JUCE_MAC
+ #include <time.h>
+#endif
+
+namespace
+{
+    struct Options
+    {
+        int numEditors = 20;
+        double seconds = 10.0;
+        juce::File jsonFile;
+    };
+
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 512;
+    constexpr int numChannels = 2;
+
+    // CPU time used by the calling thread so far, or -1 where it isn't read
+    double getThreadCPUSeconds()
+    {
+       #if JUCE_LINUX || JUCE_MAC
+        timespec time;
+
+        if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) == 0)
+            return (double) time.tv_sec + (double) time.tv_nsec * 1.0e-9;
+       #endif
+
+        return -1.0;
+    }
+
+    //==============================================================================
+    // Feeds every processor a block of noise each block period
+    class AudioThread : public juce::Thread
+    {
+    public:
+        explicit AudioThread(std::vector<std::unique_ptr<VinylAudioProcessor>>& processorsToFeed)
+            : juce::Thread("Vinyl audio"), processors(processorsToFeed)
+        {
+        }
+
+        void run() override
+        {
+            juce::AudioBuffer<float> noise(numChannels, blockSize), buffer(numChannels, blockSize);
+            juce::MidiBuffer midi;
+            juce::Random random(1);
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                for (int i = 0; i < blockSize; ++i)
+                    noise.setSample(channel, i, random.nextFloat() - 0.5f);
+
+            const auto blockMilliseconds = 1000.0 * blockSize / sampleRate;
+            auto nextBlock = juce::Time::getMillisecondCounterHiRes();
+
+            while (! threadShouldExit())
+            {
+                for (auto& processor : processors)
+                {
+                    for (int channel = 0; channel < numChannels; ++channel)
+                        buffer.copyFrom(channel, 0, noise, channel, 0, blockSize);
+
+                    processor->processBlock(buffer, midi);
+                }
+
+                nextBlock += blockMilliseconds;
+                const auto waitMilliseconds = nextBlock - juce::Time::getMillisecondCounterHiRes();
+
+                if (waitMilliseconds >= 1.0)
+                    sleep((int) waitMilliseconds);
+            }
+        }
+
+    private:
+        std::vector<std::unique_ptr<VinylAudioProcessor>>& processors;
+    };
+
+    // Measures the message thread's CPU use with the controls buffered, then
+    // unbuffered, letting the editors settle for a second after each switch.
+    // All inside one run of the message loop, which it stops at the end.
+    class Measurement : private juce::Timer
+    {
+    public:
+        Measurement(std::vector<std::unique_ptr<VinylAudioProcessorEditor>>& editorsToMeasure, double secondsPerMode)
+            : editors(editorsToMeasure), seconds(secondsPerMode)
+        {
+            startMode();
+        }
+
+        static constexpr int numModes = 2;
+        std::array<double, numModes> cpuPercent { -1.0, -1.0 };    // Buffered, unbuffered
+
+        static bool isBuffered(int mode) noexcept   { return mode == 0; }
+
+    private:
+        void startMode()
+        {
+            for (auto& editor : editors)
+            {
+                editor->setControlsBufferedToImage(isBuffered(mode));
+                editor->repaint();
+            }
+
+            measuring = false;
+            startTimer(1000);
+        }
+
+        void timerCallback() override
+        {
+            const auto cpuSeconds = getThreadCPUSeconds();
+            const auto wallMilliseconds = juce::Time::getMillisecondCounterHiRes();
+
+            if (! measuring)
+            {
+                startCPUSeconds = cpuSeconds;
+                startWallMilliseconds = wallMilliseconds;
+                measuring = true;
+                startTimer(juce::jmax(1, juce::roundToInt(seconds * 1000.0)));
+                return;
+            }
+
+            if (startCPUSeconds >= 0.0)
+                cpuPercent[(size_t) mode] = 100.0 * (cpuSeconds - startCPUSeconds)
+                                                  / juce::jmax(1.0e-9, (wallMilliseconds - startWallMilliseconds) * 0.001);
+
+            if (++mode < numModes)
+            {
+                startMode();
+                return;
+            }
+
+            stopTimer();
+            juce::MessageManager::getInstance()->stopDispatchLoop();
+        }
+
+        std::vector<std::unique_ptr<VinylAudioProcessorEditor>>& editors;
+        const double seconds;
+        int mode = 0;
+        bool measuring = false;
+        double startCPUSeconds = 0.0, startWallMilliseconds = 0.0;
+    };
+
+    //==============================================================================
+    // Average milliseconds to paint the editor into an image, either whole or
+    // clipped to the given areas
+    double timePaint(VinylAudioProcessorEditor& editor, const juce::RectangleList<int>& clip, int numPaints)
+    {
+        using Clock = std::chrono::steady_clock;
+
+        juce::Image image(juce::Image::RGB, editor.getWidth(), editor.getHeight(), true);
+        double totalSeconds = 0.0;
+
+        // One untimed paint fills the buffered controls' caches
+        for (int i = -1; i < numPaints; ++i)
+        {
+            juce::Graphics g(image);
+
+            if (! clip.isEmpty())
+                g.reduceClipRegion(clip);
+
+            const auto start = Clock::now();
+            editor.paintEntireComponent(g, false);
+
+            if (i >= 0)
+                totalSeconds += std::chrono::duration<double>(Clock::now() - start).count();
+        }
+
+        return totalSeconds * 1.0e3 / numPaints;
+    }
+
+    // Bounds of the editor's children that repaint on every timer tick
+    juce::RectangleList<int> getAnimatedAreas(VinylAudioProcessorEditor& editor)
+    {
+        juce::RectangleList<int> areas;
+
+        for (auto* child : editor.getChildren())
+            if (dynamic_cast<LevelMeter*>(child) != nullptr || dynamic_cast<SpectrumDisplay*>(child) != nullptr)
+                areas.add(child->getBounds());
+
+        return areas;
+    }
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args(argc, argv);
+
+    Options options;
+
+    for (int i = 0; i + 1 < args.size(); ++i)
+    {
+        const auto& arg = args[i];
+
+        if (arg == "--editors")
+            options.numEditors = juce::jmax(1, args[++i].text.getIntValue());
+        else if (arg == "--seconds")
+            options.seconds = juce::jmax(0.1, args[++i].text.getDoubleValue());
+        else if (arg == "--json")
+            options.jsonFile = args[++i].resolveAsFile();
+    }
+
+    const auto& mediumCrackle = VinylAudioProcessor::cracklePresets[2];
+
+    // Every animated part of the editor busy: crackle, the EQ curve, wobble
+    const std::pair<const char*, float> parameters[] { { "EQ_MODE", 1.0f },
+                                                       { "FIRST_EQ", 0.5f },
+                                                       { "CRACKLE_DENSITY", mediumCrackle.density },
+                                                       { "CRACKLE_LEVEL", mediumCrackle.level },
+                                                       { "SATURATION", 0.5f },
+                                                       { "WOBBLE", 0.5f } };
+
+    std::vector<std::unique_ptr<VinylAudioProcessor>> processors;
+    std::vector<std::unique_ptr<VinylAudioProcessorEditor>> editors;
+
+    const auto channelSet = juce::AudioChannelSet::canonicalChannelSet(numChannels);
+
+    juce::AudioProcessor::BusesLayout layout;
+    layout.inputBuses.add(channelSet);
+    layout.outputBuses.add(channelSet);
+
+    for (int i = 0; i < options.numEditors; ++i)
+    {
+        auto processor = std::make_unique<VinylAudioProcessor>();
+
+        for (auto& [id, value] : parameters)
+            if (auto* parameter = processor->getParameters().getParameter(id))
+                parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+
+        processor->setBusesLayout(layout);
+        processor->setRateAndBufferSizeDetails(sampleRate, blockSize);
+        processor->prepareToPlay(sampleRate, blockSize);
+
+        editors.push_back(std::make_unique<VinylAudioProcessorEditor>(*processor));
+        processors.push_back(std::move(processor));
+    }
+
+    auto* report = new juce::DynamicObject();
+    const juce::var reportVar(report);
+
+    report->setProperty("editors", options.numEditors);
+    report->setProperty("cpu", juce::SystemStats::getCpuModel());
+
+    //==============================================================================
+    // Offscreen paints of one editor
+    {
+        constexpr int numPaints = 200;
+        auto& editor = *editors.front();
+        const auto animatedAreas = getAnimatedAreas(editor);
+
+        std::cout << "paint, one editor       buffered ms   unbuffered ms" << std::endl;
+
+        double timings[2][2] {};
+
+        for (auto buffered : { true, false })
+        {
+            editor.setControlsBufferedToImage(buffered);
+            timings[0][buffered ? 0 : 1] = timePaint(editor, {}, numPaints);
+            timings[1][buffered ? 0 : 1] = timePaint(editor, animatedAreas, numPaints);
+        }
+
+        editor.setControlsBufferedToImage(true);
+
+        const char* const names[] { "full repaint", "meter and spectrum" };
+
+        for (int i = 0; i < 2; ++i)
+        {
+            std::cout << juce::String(names[i]).paddedRight(' ', 20)
+                      << juce::String(timings[i][0], 3).paddedLeft(' ', 16)
+                      << juce::String(timings[i][1], 3).paddedLeft(' ', 16) << std::endl;
+        }
+
+        report->setProperty("fullRepaintMs", timings[0][0]);
+        report->setProperty("fullRepaintUnbufferedMs", timings[0][1]);
+        report->setProperty("animatedRepaintMs", timings[1][0]);
+        report->setProperty("animatedRepaintUnbufferedMs", timings[1][1]);
+    }
+
+    //==============================================================================
+    // Every editor open on screen, with audio running
+    if (juce::Desktop::getInstance().getDisplays().getPrimaryDisplay() == nullptr)
+    {
+        std::cout << std::endl << "No display, so no editor windows" << std::endl;
+    }
+    else
+    {
+        for (size_t i = 0; i < editors.size(); ++i)
+        {
+            auto& editor = *editors[i];
+            editor.setTopLeftPosition(40 + 30 * (int) (i % 10), 40 + 30 * (int) (i % 10));
+            editor.addToDesktop(juce::ComponentPeer::windowHasTitleBar);
+            editor.setVisible(true);
+        }
+
+        AudioThread audioThread(processors);
+        audioThread.startThread();
+
+        std::cout << std::endl << options.numEditors << " editors open for " << juce::String(options.seconds, 1)
+                  << " s" << std::endl
+                  << "controls      message thread CPU %   per editor %" << std::endl;
+
+        Measurement measurement(editors, options.seconds);
+        juce::MessageManager::getInstance()->runDispatchLoop();
+
+        for (int mode = 0; mode < Measurement::numModes; ++mode)
+        {
+            const auto name = Measurement::isBuffered(mode) ? "buffered" : "unbuffered";
+            const auto percent = measurement.cpuPercent[(size_t) mode];
+
+            if (percent < 0.0)
+            {
+                std::cout << juce::String(name).paddedRight(' ', 12) << "   not measured on this platform" << std::endl;
+                continue;
+            }
+
+            std::cout << juce::String(name).paddedRight(' ', 12)
+                      << juce::String(percent, 2).paddedLeft(' ', 24)
+                      << juce::String(percent / options.numEditors, 3).paddedLeft(' ', 15) << std::endl;
+
+            report->setProperty(juce::String(name) + "MessageThreadPercent", percent);
+        }
+
+        audioThread.stopThread(-1);
+
+        for (auto& editor : editors)
+            editor->removeFromDesktop();
+    }
+
+    editors.clear();
+
+    for (auto& processor : processors)
+        processor->releaseResources();
+
+    if (options.jsonFile != juce::File())
+    {
+        if (! options.jsonFile.replaceWithText(juce::JSON::toString(reportVar)))
+        {
+            std::cerr << "Can't write " << options.jsonFile.getFullPathName() << std::endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,14 @@
+#include "../PluginProcessor.h"
+
+//==============================================================================
+
+// The processor's editor factory for the tools, which are built without the editor
+bool VinylAudioProcessor::hasEditor() const
+{
+    return false;
+}
+
+juce::AudioProcessorEditor* VinylAudioProcessor::createEditor()
+{
+    return nullptr;
+}
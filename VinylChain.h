@@ -0,0 +1,271 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "CrackleGenerator.h"
+#include "GainStage.h"
+#include "LinearPhaseEQ.h"
+#include "SaturationStage.h"
+#include "VinylEQ.h"
+#include "WowFlutter.h"
+
+//==============================================================================
+// Parameter values for one block, read from the APVTS by the processor
+struct VinylSettings
+{
+    float volume = 0.5f;
+    float firstEQ = 0.0f, lowCut = 0.0f, highCut = 0.0f;
+    bool linearPhaseEQ = false;
+    float crackleDensity = 0.0f, crackleLevel = 0.0f;
+    float saturation = 0.0f;
+    int oversampling = 1, oversamplingFilter = 0;
+    float wobble = 0.0f;
+    bool wobbleLinked = true;
+    int wobbleInterpolation = 1;    // WowFlutter::Interpolation
+    int crackleVoices = CrackleGenerator<float>::maxVoices;
+};
+
+//==============================================================================
+// Quality modes, from the QUALITY parameter. Eco saves CPU and latency while
+// tracking; High spends more on fidelity for mixdown, and is what offline
+// renders use. Both adjust the user's settings rather than replacing them.
+enum class VinylQuality { eco = 0, normal, high };
+
+inline VinylSettings applyQuality(VinylSettings settings, VinylQuality quality) noexcept
+{
+    switch (quality)
+    {
+        case VinylQuality::eco:
+            settings.oversampling = juce::jmax(0, settings.oversampling - 1);   // One factor down, 1x at least
+            settings.linearPhaseEQ = false;                                     // No convolution and no FIR latency
+            settings.wobbleInterpolation = 0;                                   // Linear
+            settings.crackleVoices = 4;
+            break;
+
+        case VinylQuality::high:
+            settings.oversampling = juce::jmin(2, settings.oversampling + 1);   // One factor up, 4x at most
+            break;
+
+        case VinylQuality::normal:
+            break;
+    }
+
+    return settings;
+}
+
+//==============================================================================
+/*
+    The whole effect at one sample type: crackle, volume, EQ (minimum or
+    linear phase), saturation and wobble, plus the silence bypass.
+
+    VinylAudioProcessor holds a float and a double chain and prepares the one
+    matching the host's processing precision. Every stage is a template on
+    the sample type, so both precisions run the same code, with the biquad
+    kernels specialised for each type and stage count at compile time.
+
+    process() cuts whatever the host passes, from one sample to more than
+    prepare() was told, into chunks of subBlockSize samples and a shorter
+    leftover, without buffering, so it adds no latency. Every stage is
+    prepared for a single chunk, so no block size reallocates anything.
+*/
+template <typename SampleType>
+class VinylChain
+{
+public:
+    using Saturation = SaturationStage<SampleType>;
+
+    VinylChain() = default;
+
+    //==============================================================================
+    // The spec's maximumBlockSize doesn't matter: stages only ever see one chunk
+    void prepare(const juce::dsp::ProcessSpec& spec, const VinylSettings& settings, juce::uint32 seed)
+    {
+        auto chunkSpec = spec;
+        chunkSpec.maximumBlockSize = (juce::uint32) subBlockSize;
+
+        crackle.setSeed(seed);
+        crackle.prepare(chunkSpec);
+
+        // Snap the smoothed settings to their values before preparing, so the
+        // first block doesn't ramp from the defaults
+        linearPhase = settings.linearPhaseEQ;
+        setSettings(settings);
+        volumeGain.prepare(chunkSpec);
+        eq.prepare(chunkSpec);
+        linearEQ.prepare(chunkSpec);
+        saturation.prepare(chunkSpec);
+
+        wobble.setSeed(seed);
+        wobble.prepare(chunkSpec);
+
+        // Longest a sound can take to come out of the chain, at any setting
+        silenceHoldSamples = (juce::int64) std::ceil(WowFlutter<SampleType>::getMaximumDelaySeconds() * spec.sampleRate)
+                           + (juce::int64) std::ceil(saturation.getLatencyInSamples(Saturation::Factor::fourTimes,
+                                                                                    Saturation::FilterMode::linearPhase))
+                           + linearEQ.getTailLengthInSamples()
+                           + subBlockSize;
+
+        // Longest the output can keep sounding once the input stops: all of
+        // the above, plus the minimum-phase EQ ringing down and a pop that
+        // started on the last sample
+        tailLengthSamples = silenceHoldSamples
+                          + (juce::int64) std::ceil((VinylEQ<SampleType>::getDecaySeconds()
+                                                     + CrackleGenerator<SampleType>::getMaximumPopSeconds()) * spec.sampleRate);
+        silentSamples = 0;
+        isSkippingSilence = false;
+    }
+
+    // Called once per block. Every stage smooths its own values towards the
+    // new ones; the EQ redesigns its filters along the way.
+    void setSettings(const VinylSettings& settings) noexcept
+    {
+        eq.setFirstEQ((SampleType) settings.firstEQ);
+        eq.setLowCut((SampleType) settings.lowCut);
+        eq.setHighCut((SampleType) settings.highCut);
+        linearEQ.setValues(settings.linearPhaseEQ, (SampleType) settings.firstEQ,
+                           (SampleType) settings.lowCut, (SampleType) settings.highCut);
+
+        // Start the newly selected EQ from silence rather than stale state
+        if (settings.linearPhaseEQ != linearPhase)
+        {
+            linearPhase = settings.linearPhaseEQ;
+
+            if (linearPhase)
+                linearEQ.reset();
+            else
+                eq.reset();
+        }
+
+        crackle.setDensity(settings.crackleDensity);
+        crackle.setLevel(settings.crackleLevel);
+        crackle.setMaxVoices(settings.crackleVoices);
+        volumeGain.setGain((SampleType) settings.volume);
+        saturation.setAmount((SampleType) settings.saturation);
+        saturation.setOversampling((typename Saturation::Factor) settings.oversampling,
+                                   (typename Saturation::FilterMode) settings.oversamplingFilter);
+        wobble.setAmount((SampleType) settings.wobble);
+        wobble.setChannelsLinked(settings.wobbleLinked);
+        wobble.setInterpolation((typename WowFlutter<SampleType>::Interpolation) settings.wobbleInterpolation);
+    }
+
+    // A bypassed saturation stage skips oversampling too, and adds no latency.
+    // Neither does a bypassed wobble stage. Valid after prepare().
+    float getLatencyInSamples(const VinylSettings& settings) const noexcept
+    {
+        auto latency = 0.0f;
+
+        if (settings.linearPhaseEQ)
+            latency += (float) linearEQ.getLatencyInSamples();
+
+        if (settings.saturation > 0.0f)
+            latency += saturation.getLatencyInSamples((typename Saturation::Factor) settings.oversampling,
+                                                      (typename Saturation::FilterMode) settings.oversamplingFilter);
+
+        if (settings.wobble > 0.0f)
+            latency += wobble.getLatencyInSamples();
+
+        return latency;
+    }
+
+    // The tail at any setting, for hosts and offline renders. Valid after prepare().
+    juce::int64 getTailLengthInSamples() const noexcept     { return tailLengthSamples; }
+
+    //==============================================================================
+    // Processes the buffer in place. Returns false if the block was skipped
+    // as silence, in which case the buffer has been cleared.
+    bool process(juce::AudioBuffer<SampleType>& buffer, int numInputChannels) noexcept
+    {
+        if (canSkipBlock(buffer, numInputChannels))
+        {
+            buffer.clear();
+            return false;
+        }
+
+        // Crackle, volume, every enabled EQ section, saturation and wobble run
+        // back to back on each sub-block while it is still in cache
+        juce::dsp::AudioBlock<SampleType> block(buffer);
+        const auto numSamples = block.getNumSamples();
+
+        for (size_t start = 0; start < numSamples; start += (size_t) subBlockSize)
+        {
+            auto subBlock = block.getSubBlock(start, juce::jmin((size_t) subBlockSize, numSamples - start));
+            juce::dsp::ProcessContextReplacing<SampleType> context(subBlock);
+
+            crackle.process(context);
+            volumeGain.process(context);
+
+            if (linearPhase)
+                linearEQ.process(context);
+            else
+                eq.process(context);
+
+            saturation.process(context);
+            wobble.process(context);
+        }
+
+        return true;
+    }
+
+private:
+    //==============================================================================
+    static constexpr int subBlockSize = BiquadCascade<SampleType>::subBlockSize;
+
+    // Silence bypass. Once the input has been silent for longer than any delay
+    // in the chain, with no crackle and the EQ decayed, blocks are skipped
+    // until the input comes back.
+    static constexpr SampleType silenceThreshold = (SampleType) 1.0e-6;  // -120 dB
+
+    bool canSkipBlock(const juce::AudioBuffer<SampleType>& buffer, int numInputChannels) noexcept
+    {
+        const auto numSamples = buffer.getNumSamples();
+        auto peak = SampleType();
+
+        for (int channel = 0; channel < numInputChannels; ++channel)
+        {
+            const auto range = juce::FloatVectorOperations::findMinAndMax(buffer.getReadPointer(channel), numSamples);
+            peak = juce::jmax(peak, -range.getStart(), range.getEnd());
+        }
+
+        if (peak > silenceThreshold || crackle.isActive())
+        {
+            silentSamples = 0;
+            isSkippingSilence = false;
+            return false;
+        }
+
+        silentSamples += numSamples;
+
+        if (isSkippingSilence)
+            return true;
+
+        // Wait for the delay lines and oversamplers to flush and the EQ to decay
+        if (silentSamples < silenceHoldSamples || ! eq.isSettled(silenceThreshold))
+            return false;
+
+        // What is left is below the threshold. Drop it, so the next sound starts
+        // from a clean state rather than from whatever was there before the gap.
+        eq.reset();
+        linearEQ.reset();
+        saturation.reset();
+        wobble.reset();
+
+        isSkippingSilence = true;
+        return true;
+    }
+
+    //==============================================================================
+    CrackleGenerator<SampleType> crackle;
+    GainStage<SampleType> volumeGain;
+    VinylEQ<SampleType> eq;
+    LinearPhaseEQ<SampleType> linearEQ;
+    Saturation saturation;
+    WowFlutter<SampleType> wobble;
+
+    juce::int64 silentSamples = 0;
+    juce::int64 silenceHoldSamples = 0;
+    juce::int64 tailLengthSamples = 0;
+    bool isSkippingSilence = false;
+
+    bool linearPhase = false;   // Which EQ runs
+
+    JUCE_DECLARE_NON_COPYABLE(VinylChain)
+};
@@ -0,0 +1,264 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "BiquadCascade.h"
+#include "BiquadDesign.h"
+#include "SharedAssets.h"
+
+//==============================================================================
+/*
+    The three EQ controls (Vinyl EQ, Low Cut, High Cut) and the fused biquad
+    cascade that runs them.
+
+    Each control is smoothed and its sections are updated on the audio thread
+    every automationStep samples, so host automation sweeps the filters
+    instead of jumping once per block. A section is only updated when its
+    control actually moved since the last step, so static settings cost
+    nothing. A control at 0 takes its sections out of the cascade.
+
+    Updates don't design filters: prepare() fetches a table of coefficients
+    across the control's 0-1 range, and the audio thread interpolates
+    between neighbouring entries. Tables come from SharedAssets, so every
+    instance running at the same sample rate uses the same ones.
+*/
+template <typename SampleType>
+class VinylEQ
+{
+public:
+    static constexpr int automationStep = 32;
+
+    enum Control { firstEQ = 0, lowCut, highCut, numControls };
+
+    static constexpr int maxSectionsPerControl = 3;
+
+    // Number of sections a control sets
+    static constexpr int getNumSections(Control control) noexcept
+    {
+        return control == firstEQ ? 3 : 1;
+    }
+
+    // Designs a control's sections directly, for a value above 0
+    template <typename CoefficientType>
+    static void design(Control control, double sampleRate, double value,
+                       BiquadCoefficients<CoefficientType>* sections) noexcept
+    {
+        switch (control)
+        {
+            case lowCut:
+                // High-pass from 80Hz to 280Hz
+                sections[0] = BiquadDesign::makeHighPass<CoefficientType>(sampleRate, 80.0 + value * 200.0);
+                break;
+
+            case highCut:
+                // Low-pass from 10kHz down to 5kHz
+                sections[0] = BiquadDesign::makeLowPass<CoefficientType>(sampleRate, 10000.0 - value * 5000.0);
+                break;
+
+            case firstEQ:
+            {
+                // Non-linear response to the slider
+                const auto curve = value * value;
+                sections[0] = BiquadDesign::makeHighPass<CoefficientType>(sampleRate, 80.0, 1.0 - curve * 0.3);            // Sub-Bass Cut (below 80 Hz)
+                sections[1] = BiquadDesign::makePeakFilter<CoefficientType>(sampleRate, 325.0, 1.0, 1.0 + curve * 0.5);    // Low-Mid Boost (150 Hz - 500 Hz)
+                sections[2] = BiquadDesign::makeLowPass<CoefficientType>(sampleRate, 10000.0, 1.0 - curve * 0.15);         // High-Frequency Roll-Off (above 10 kHz)
+                break;
+            }
+
+            case numControls:
+                break;
+        }
+    }
+
+    //==============================================================================
+    /*
+        Coefficients for one control at tableSize + 1 evenly spaced values
+        across 0-1. Lookups interpolate linearly between neighbouring entries;
+        every entry is a stable biquad and the stable region is convex, so
+        interpolated ones are stable too. Entries are kept in double precision
+        and rounded once, so a lookup is as close to the direct design as the
+        interpolation allows.
+
+        The entries are a SharedAsset per control and sample rate; a table is
+        only a handle to them, and cheap to copy.
+    */
+    class CoefficientTable
+    {
+    public:
+        static constexpr int tableSize = 1024;
+
+        CoefficientTable() = default;
+
+        // Fetches or builds the entries. Not for the audio thread.
+        CoefficientTable(Control control, double sampleRate)
+            : numSections(getNumSections(control))
+        {
+            const auto name = "eq-" + juce::String((int) control);
+            const auto tableRate = SharedAssets::getKeyRate(sampleRate);
+            const auto numEntries = (size_t) ((tableSize + 1) * numSections);
+
+            asset = SharedAssets::get<BiquadCoefficients<double>>({ name, tableRate, 0 }, numEntries,
+                [control, tableRate, numEntries](std::vector<BiquadCoefficients<double>>& table)
+                {
+                    const auto sections = getNumSections(control);
+                    table.resize(numEntries);
+
+                    for (int i = 0; i <= tableSize; ++i)
+                        design(control, tableRate, (double) i / tableSize, table.data() + i * sections);
+                });
+
+            entries = asset->template getData<BiquadCoefficients<double>>();
+        }
+
+        void lookup(SampleType value, BiquadCoefficients<SampleType>* sections) const noexcept
+        {
+            const auto position = juce::jlimit(0.0, 1.0, (double) value) * tableSize;
+            const auto index = juce::jmin((int) position, tableSize - 1);
+            const auto fraction = position - index;
+
+            const auto* lower = entries + index * numSections;
+            const auto* upper = lower + numSections;
+
+            for (int s = 0; s < numSections; ++s)
+            {
+                const auto& a = lower[s];
+                const auto& b = upper[s];
+
+                sections[s] = { (SampleType) (a.b0 + fraction * (b.b0 - a.b0)),
+                                (SampleType) (a.b1 + fraction * (b.b1 - a.b1)),
+                                (SampleType) (a.b2 + fraction * (b.b2 - a.b2)),
+                                (SampleType) (a.a1 + fraction * (b.a1 - a.a1)),
+                                (SampleType) (a.a2 + fraction * (b.a2 - a.a2)) };
+            }
+        }
+
+    private:
+        int numSections = 0;
+        std::shared_ptr<const SharedAsset> asset;
+        const BiquadCoefficients<double>* entries = nullptr;    // [value][section]
+    };
+
+    //==============================================================================
+    VinylEQ() = default;
+
+    // Snaps every control to its target and fetches the tables for the new rate
+    void prepare(const juce::dsp::ProcessSpec& spec)
+    {
+        filters.prepare(spec);
+
+        for (int i = 0; i < numControls; ++i)
+        {
+            auto& control = controls[(size_t) i];
+            control.table = CoefficientTable((Control) i, spec.sampleRate);
+            control.value.reset(spec.sampleRate, smoothingSeconds);
+            control.appliedValue = -1;
+        }
+
+        updateCoefficients(0);
+    }
+
+    void reset() noexcept
+    {
+        filters.reset();
+    }
+
+    //==============================================================================
+    void setFirstEQ(SampleType value) noexcept  { controls[firstEQ].value.setTargetValue(value); }
+    void setLowCut(SampleType value) noexcept   { controls[lowCut].value.setTargetValue(value); }
+    void setHighCut(SampleType value) noexcept  { controls[highCut].value.setTargetValue(value); }
+
+    bool isSettled(SampleType threshold) const noexcept { return filters.isSettled(threshold); }
+
+    // How long the EQ rings after its input stops, down 60 dB. The slowest
+    // poles are the 80Hz high-pass at a Q of 1, which decay as exp(-pi f t / Q);
+    // doubled, as the Low Cut can put a second high-pass on the same frequency.
+    static double getDecaySeconds() noexcept
+    {
+        constexpr double frequency = 80.0, q = 1.0;
+        return 2.0 * std::log(1000.0) * q / (juce::MathConstants<double>::pi * frequency);
+    }
+
+    //==============================================================================
+    void process(const juce::dsp::ProcessContextReplacing<SampleType>& context) noexcept
+    {
+        auto& block = context.getOutputBlock();
+        const auto numSamples = block.getNumSamples();
+
+        for (size_t start = 0; start < numSamples; start += (size_t) automationStep)
+        {
+            const auto length = juce::jmin((size_t) automationStep, numSamples - start);
+            auto subBlock = block.getSubBlock(start, length);
+
+            updateCoefficients((int) length);
+
+            if (length == (size_t) automationStep)
+                filters.template process<automationStep>(juce::dsp::ProcessContextReplacing<SampleType>(subBlock));
+            else
+                filters.process(juce::dsp::ProcessContextReplacing<SampleType>(subBlock));
+        }
+    }
+
+private:
+    //==============================================================================
+    // Every EQ section runs in one fused cascade, in this order
+    enum FilterStage
+    {
+        lowCutStage = 0,    // Low-Cut Filter for the second slider
+        highCutStage,       // High-Cut Filter for the third slider
+        subBassStage,       // Sub-Bass Cut filter (below 80Hz)
+        lowMidStage,        // Low-Mid Boost filter (150Hz to 500Hz)
+        highFreqStage,      // High-Frequency Roll-Off (above 10kHz)
+        numFilterStages
+    };
+
+    static_assert(numFilterStages <= BiquadCascade<SampleType>::maxStages, "Too many EQ stages for the cascade");
+
+    // First cascade stage of each control's sections, which are consecutive
+    static constexpr FilterStage getFirstStage(Control control) noexcept
+    {
+        return control == lowCut ? lowCutStage : control == highCut ? highCutStage : subBassStage;
+    }
+
+    struct SmoothedControl
+    {
+        juce::SmoothedValue<SampleType, juce::ValueSmoothingTypes::Linear> value;
+        SampleType appliedValue = -1;   // Value the cascade's coefficients are for
+        CoefficientTable table;
+    };
+
+    static constexpr double smoothingSeconds = 0.05;
+
+    //==============================================================================
+    // Moves every control on by numSamples and updates the sections whose
+    // value changed, using the value reached at the end of the step
+    void updateCoefficients(int numSamples) noexcept
+    {
+        for (int i = 0; i < numControls; ++i)
+        {
+            auto& control = controls[(size_t) i];
+            const auto value = numSamples > 0 ? control.value.skip(numSamples) : control.value.getTargetValue();
+
+            if (value == control.appliedValue)
+                continue;
+
+            control.appliedValue = value;
+
+            const auto firstStage = (int) getFirstStage((Control) i);
+            const auto numSections = getNumSections((Control) i);
+            std::array<BiquadCoefficients<SampleType>, maxSectionsPerControl> sections;
+
+            control.table.lookup(value, sections.data());
+
+            for (int s = 0; s < numSections; ++s)
+            {
+                filters.setCoefficients(firstStage + s, sections[(size_t) s]);
+                filters.setStageEnabled(firstStage + s, value > SampleType(0));
+            }
+        }
+    }
+
+    //==============================================================================
+    std::array<SmoothedControl, numControls> controls;
+    BiquadCascade<SampleType> filters;
+
+    JUCE_DECLARE_NON_COPYABLE(VinylEQ)
+};
@@ -0,0 +1,388 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "SharedAssets.h"
+
+//==============================================================================
+/*
+    Wow and flutter: pitch wobble from a modulated fractional delay line.
+
+    The delay moves around a fixed centre, a whole number of samples, which
+    is the latency this stage adds while it is on. Wow is a slow sine at the
+    speed of a 33 1/3 rpm record, read with
+    linear interpolation from a wavetable shared through SharedAssets;
+    flutter is band-limited noise, random points at a faster rate joined with
+    smoothstep curves.
+
+    By default all channels share one modulation curve, so they stay phase
+    coherent and the stereo or surround image doesn't wander. Unlinked, every
+    channel gets its own wow phase and flutter noise; switching crossfades
+    between the shared and the own curves, so the delay never jumps.
+
+    The delay line is read with linear, third-order Lagrange or first-order
+    Thiran allpass interpolation. The choice is made once per block and the
+    per-sample loop is a template, so there is no branch inside it.
+
+    Everything is allocated in prepare(). An amount of 0 bypasses the stage
+    with no latency once the depth has ramped down. Turning it on or off
+    crossfades between the dry input and the delayed output over the same
+    ramp, and the line keeps taking the input while bypassed, so the
+    crossfade back in reads recent audio rather than silence.
+*/
+template <typename SampleType>
+class WowFlutter
+{
+public:
+    enum class Interpolation { linear = 0, lagrange, allpass };
+
+    WowFlutter() = default;
+
+    //==============================================================================
+    void prepare(const juce::dsp::ProcessSpec& spec)
+    {
+        sampleRate = spec.sampleRate;
+        numChannels = (int) spec.numChannels;
+
+        centreDelay = (SampleType) std::round(centreDelayMs * 0.001 * sampleRate);
+        wowDepth = (SampleType) (wowDepthMs * 0.001 * sampleRate);
+        flutterDepth = (SampleType) (flutterDepthMs * 0.001 * sampleRate);
+        wowIncrement = (SampleType) (wowRateHz / sampleRate);
+        flutterIncrement = (SampleType) (flutterRateHz / sampleRate);
+
+        // Room for the longest delay plus the interpolators' extra taps
+        lineSize = juce::nextPowerOfTwo((int) std::ceil(centreDelay + wowDepth + flutterDepth) + 4);
+        lineMask = lineSize - 1;
+        lines.assign((size_t) (lineSize * numChannels), SampleType());
+        allpassStates.assign((size_t) numChannels, SampleType());
+        modulators.resize((size_t) juce::jmax(1, numChannels));
+
+        amount.reset(sampleRate, 0.05);
+        wet.reset(sampleRate, 0.05);
+        spread.reset(sampleRate, 0.05);
+
+        sineTable = SharedAssets::get<SampleType>({ "wow-sine", 0.0, 0 }, (size_t) tableSize + 1, [](std::vector<SampleType>& table)
+        {
+            table.resize((size_t) tableSize + 1);
+
+            for (int i = 0; i <= tableSize; ++i)
+                table[(size_t) i] = (SampleType) std::sin(juce::MathConstants<double>::twoPi * i / tableSize);
+        });
+
+        sine = sineTable->template getData<SampleType>();
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        std::fill(lines.begin(), lines.end(), SampleType());
+        std::fill(allpassStates.begin(), allpassStates.end(), SampleType());
+        writePosition = 0;
+
+        // The first channel's curve is the shared one. The others start at
+        // evenly spread wow phases, each with its own noise.
+        for (size_t channel = 0; channel < modulators.size(); ++channel)
+        {
+            auto& modulator = modulators[channel];
+            modulator.random.setSeed((juce::int64) seed + (juce::int64) channel * 0x9e3779b9);
+            modulator.wowPhase = (SampleType) channel / (SampleType) modulators.size();
+            modulator.flutterPhase = 0;
+            modulator.flutterFrom = nextFlutterTarget(modulator);
+            modulator.flutterTo = nextFlutterTarget(modulator);
+        }
+    }
+
+    void setSeed(juce::uint32 newSeed) noexcept     { seed = newSeed; }
+
+    // 0 bypasses the stage, 1 is the deepest wobble
+    void setAmount(SampleType newAmount) noexcept
+    {
+        amount.setTargetValue(juce::jlimit(SampleType(0), SampleType(1), newAmount));
+        wet.setTargetValue(amount.getTargetValue() > SampleType(0) ? SampleType(1) : SampleType(0));
+    }
+
+    void setInterpolation(Interpolation newInterpolation) noexcept  { interpolation = newInterpolation; }
+
+    // Linked channels share one modulation curve and stay phase coherent
+    void setChannelsLinked(bool shouldBeLinked) noexcept
+    {
+        spread.setTargetValue(shouldBeLinked ? SampleType(0) : SampleType(1));
+    }
+
+    bool isBypassed() const noexcept
+    {
+        return amount.getTargetValue() <= SampleType(0) && ! amount.isSmoothing() && ! wet.isSmoothing();
+    }
+
+    // The centre of the modulated delay, the latency while the stage is on.
+    // A bypassed stage adds none. Valid after prepare().
+    float getLatencyInSamples() const noexcept      { return (float) centreDelay; }
+
+    // How long the input keeps sounding at the output, at the deepest setting
+    static double getMaximumDelaySeconds() noexcept
+    {
+        return (centreDelayMs + wowDepthMs + flutterDepthMs) * 0.001;
+    }
+
+    //==============================================================================
+    void process(const juce::dsp::ProcessContextReplacing<SampleType>& context) noexcept
+    {
+        auto& block = context.getOutputBlock();
+
+        if (isBypassed())
+        {
+            processBypassed(block);
+            return;
+        }
+
+        switch (interpolation)
+        {
+            case Interpolation::linear:     processWith<LinearRead>(block); break;
+            case Interpolation::lagrange:   processWith<LagrangeRead>(block); break;
+            case Interpolation::allpass:    processWith<AllpassRead>(block); break;
+        }
+    }
+
+private:
+    //==============================================================================
+    static constexpr double centreDelayMs = 2.0;
+    static constexpr double wowDepthMs = 1.5;       // About 0.5% pitch deviation at the wow rate
+    static constexpr double flutterDepthMs = 0.15;
+    static constexpr double wowRateHz = 100.0 / 180.0;  // One revolution at 33 1/3 rpm
+    static constexpr double flutterRateHz = 12.0;
+
+    static constexpr int tableSize = 1024;     // Wow wavetable, plus a guard point
+
+    //==============================================================================
+    // Each reader returns the line's content `delay` samples behind `position`
+    struct LinearRead
+    {
+        static SampleType read(const SampleType* line, int position, int mask, SampleType delay, SampleType&) noexcept
+        {
+            const auto whole = (int) delay;
+            const auto fraction = delay - (SampleType) whole;
+            const auto x0 = line[(position - whole) & mask];
+            const auto x1 = line[(position - whole - 1) & mask];
+
+            return x0 + fraction * (x1 - x0);
+        }
+    };
+
+    struct LagrangeRead
+    {
+        static SampleType read(const SampleType* line, int position, int mask, SampleType delay, SampleType&) noexcept
+        {
+            const auto whole = (int) delay;
+
+            // Taps at whole - 1 ... whole + 2, so the read point sits between the middle two
+            const auto d = delay - (SampleType) whole + SampleType(1);
+            const auto d1 = d - SampleType(1), d2 = d - SampleType(2), d3 = d - SampleType(3);
+
+            const auto xm1 = line[(position - whole + 1) & mask];
+            const auto x0 = line[(position - whole) & mask];
+            const auto x1 = line[(position - whole - 1) & mask];
+            const auto x2 = line[(position - whole - 2) & mask];
+
+            return -d1 * d2 * d3 * SampleType(1.0 / 6.0) * xm1
+                   + d * d2 * d3 * SampleType(0.5) * x0
+                   - d * d1 * d3 * SampleType(0.5) * x1
+                   + d * d1 * d2 * SampleType(1.0 / 6.0) * x2;
+        }
+    };
+
+    struct AllpassRead
+    {
+        static SampleType read(const SampleType* line, int position, int mask, SampleType delay, SampleType& state) noexcept
+        {
+            auto whole = (int) delay;
+            auto fraction = delay - (SampleType) whole;
+
+            // Keep the fractional delay where the first-order Thiran allpass is best behaved
+            if (fraction < SampleType(0.618))
+            {
+                fraction += SampleType(1);
+                --whole;
+            }
+
+            const auto alpha = (SampleType(1) - fraction) / (SampleType(1) + fraction);
+            const auto x0 = line[(position - whole) & mask];
+            const auto x1 = line[(position - whole - 1) & mask];
+
+            state = x1 + alpha * (x0 - state);
+            return state;
+        }
+    };
+
+    //==============================================================================
+    template <typename Reader>
+    void processWith(const juce::dsp::AudioBlock<SampleType>& block) noexcept
+    {
+        const auto numSamples = block.getNumSamples();
+        const auto numBlockChannels = juce::jmin(block.getNumChannels(), (size_t) numChannels);
+
+        for (size_t start = 0; start < numSamples; start += sharedDelays.size())
+        {
+            const auto length = juce::jmin(sharedDelays.size(), numSamples - start);
+            const auto isSpread = spread.isSmoothing() || spread.getTargetValue() > SampleType(0);
+            const auto isFading = wet.isSmoothing();
+
+            for (size_t i = 0; i < length; ++i)
+                amounts[i] = amount.getNextValue();
+
+            if (isFading)
+                for (size_t i = 0; i < length; ++i)
+                    wets[i] = wet.getNextValue();
+
+            fillCurve(modulators[0], sharedCurve.data(), length);
+
+            for (size_t i = 0; i < length; ++i)
+                sharedDelays[i] = centreDelay + amounts[i] * sharedCurve[i];
+
+            if (isSpread)
+                for (size_t i = 0; i < length; ++i)
+                    spreads[i] = spread.getNextValue();
+
+            for (size_t channel = 0; channel < numBlockChannels; ++channel)
+            {
+                const auto* delays = sharedDelays.data();
+
+                if (isSpread && channel > 0)
+                {
+                    fillCurve(modulators[channel], ownCurve.data(), length);
+
+                    for (size_t i = 0; i < length; ++i)
+                        ownDelays[i] = centreDelay + amounts[i] * (sharedCurve[i]
+                                                                   + spreads[i] * (ownCurve[i] - sharedCurve[i]));
+
+                    delays = ownDelays.data();
+                }
+
+                auto* data = block.getChannelPointer(channel) + start;
+                auto* line = lines.data() + (size_t) lineSize * channel;
+                auto state = allpassStates[channel];
+                auto position = writePosition;
+
+                if (isFading)
+                {
+                    for (size_t i = 0; i < length; ++i)
+                    {
+                        const auto dry = data[i];
+                        line[position] = dry;
+                        data[i] = dry + wets[i] * (Reader::read(line, position, lineMask, delays[i], state) - dry);
+                        position = (position + 1) & lineMask;
+                    }
+                }
+                else
+                {
+                    for (size_t i = 0; i < length; ++i)
+                    {
+                        line[position] = data[i];
+                        data[i] = Reader::read(line, position, lineMask, delays[i], state);
+                        position = (position + 1) & lineMask;
+                    }
+                }
+
+                allpassStates[channel] = state;
+            }
+
+            writePosition = (writePosition + (int) length) & lineMask;
+        }
+    }
+
+    // Bypassed: the block passes through untouched, but still goes into the
+    // lines for when the stage comes back
+    void processBypassed(const juce::dsp::AudioBlock<SampleType>& block) noexcept
+    {
+        const auto numSamples = block.getNumSamples();
+        const auto numBlockChannels = juce::jmin(block.getNumChannels(), (size_t) numChannels);
+
+        for (size_t channel = 0; channel < numBlockChannels; ++channel)
+        {
+            const auto* data = block.getChannelPointer(channel);
+            auto* line = lines.data() + (size_t) lineSize * channel;
+            auto position = writePosition;
+
+            for (size_t i = 0; i < numSamples; ++i)
+            {
+                line[position] = data[i];
+                position = (position + 1) & lineMask;
+            }
+        }
+
+        writePosition = (writePosition + (int) numSamples) & lineMask;
+    }
+
+    //==============================================================================
+    // One channel's modulation state: wow phase and the flutter noise
+    struct Modulator
+    {
+        SampleType wowPhase = 0;
+        SampleType flutterPhase = 0, flutterFrom = 0, flutterTo = 0;
+        juce::Random random;
+    };
+
+    // Wobble in samples at full depth for each of the next `length` samples
+    void fillCurve(Modulator& modulator, SampleType* curve, size_t length) noexcept
+    {
+        for (size_t i = 0; i < length; ++i)
+        {
+            const auto tablePosition = modulator.wowPhase * (SampleType) tableSize;
+            const auto index = (int) tablePosition;
+            const auto fraction = tablePosition - (SampleType) index;
+            const auto wow = sine[index] + fraction * (sine[index + 1] - sine[index]);
+
+            const auto phase = modulator.flutterPhase;
+            const auto smooth = phase * phase * (SampleType(3) - SampleType(2) * phase);
+            const auto flutter = modulator.flutterFrom + smooth * (modulator.flutterTo - modulator.flutterFrom);
+
+            curve[i] = wowDepth * wow + flutterDepth * flutter;
+
+            modulator.wowPhase += wowIncrement;
+
+            if (modulator.wowPhase >= SampleType(1))
+                modulator.wowPhase -= SampleType(1);
+
+            modulator.flutterPhase += flutterIncrement;
+
+            if (modulator.flutterPhase >= SampleType(1))
+            {
+                modulator.flutterPhase -= SampleType(1);
+                modulator.flutterFrom = modulator.flutterTo;
+                modulator.flutterTo = nextFlutterTarget(modulator);
+            }
+        }
+    }
+
+    static SampleType nextFlutterTarget(Modulator& modulator) noexcept
+    {
+        return (SampleType) (modulator.random.nextFloat() * 2.0f - 1.0f);
+    }
+
+    //==============================================================================
+    double sampleRate = 44100.0;
+    int numChannels = 0;
+    Interpolation interpolation = Interpolation::lagrange;
+
+    juce::SmoothedValue<SampleType, juce::ValueSmoothingTypes::Linear> amount { SampleType(0) };
+
+    // 1 while the stage is on, 0 bypassed; crossfades the output between the two
+    juce::SmoothedValue<SampleType, juce::ValueSmoothingTypes::Linear> wet { SampleType(0) };
+
+    // 0 when the channels are linked, 1 when each follows its own curve
+    juce::SmoothedValue<SampleType, juce::ValueSmoothingTypes::Linear> spread { SampleType(0) };
+    SampleType centreDelay = 0, wowDepth = 0, flutterDepth = 0;
+
+    std::vector<SampleType> lines;          // One circular buffer per channel, back to back
+    std::vector<SampleType> allpassStates;
+    int lineSize = 0, lineMask = 0, writePosition = 0;
+    std::array<SampleType, 64> amounts {}, wets {}, spreads {}, sharedCurve {}, ownCurve {}, sharedDelays {}, ownDelays {};
+
+    std::shared_ptr<const SharedAsset> sineTable;
+    const SampleType* sine = nullptr;   // One cycle, tableSize + 1 points
+
+    std::vector<Modulator> modulators;  // One per channel, the first is the shared curve
+    SampleType wowIncrement = 0, flutterIncrement = 0;
+
+    juce::uint32 seed = 1;
+
+    JUCE_DECLARE_NON_COPYABLE(WowFlutter)
+};